@@ -0,0 +1,51 @@
+#!/bin/sh
+#@file benchmark_tls.sh
+#@author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+#@date 18.10.2026
+#@brief compares the download throughput of plain HTTP, HTTPS with kernel TLS and HTTPS encrypted in user space
+#
+# Usage: ./benchmark_tls.sh [SIZE_MB] [DOWNLOADS]
+# A self-signed certificate and a test file are generated in a temporary directory. Kernel TLS needs the
+# tls module (modprobe tls), without it the kTLS run falls back to user space and the server says so.
+
+SIZE_MB=${1:-256}
+DOWNLOADS=${2:-8}
+PORT=8443
+DIR=$(mktemp -d)
+trap 'kill $SERVER 2>/dev/null; rm -rf "$DIR"' EXIT
+
+make -s server client || exit 1
+
+openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes -days 1 \
+    -subj "/CN=localhost" -addext "subjectAltName=DNS:localhost" \
+    -keyout "$DIR/key.pem" -out "$DIR/cert.pem" 2>/dev/null || exit 1
+mkdir "$DIR/www"
+dd if=/dev/urandom of="$DIR/www/test.bin" bs=1M count="$SIZE_MB" 2>/dev/null
+
+# run NAME SCHEME SERVER_OPTIONS...: start the server, download the file DOWNLOADS times and print MB/s
+run() {
+    name=$1
+    scheme=$2
+    shift 2
+    ./server -p $PORT "$@" "$DIR/www" 2>"$DIR/server.log" &
+    SERVER=$!
+    sleep 0.5
+    ./client -p $PORT -c "$DIR/cert.pem" -o /dev/null "$scheme://localhost/test.bin" 2>/dev/null # warm up
+    start=$(date +%s.%N)
+    i=0
+    while [ $i -lt "$DOWNLOADS" ]; do
+        ./client -p $PORT -c "$DIR/cert.pem" -o /dev/null "$scheme://localhost/test.bin" 2>/dev/null || exit 1
+        i=$((i + 1))
+    done
+    end=$(date +%s.%N)
+    kill $SERVER
+    wait $SERVER 2>/dev/null
+    echo "$name $start $end" | awk -v mb=$((SIZE_MB * DOWNLOADS)) \
+        '{ printf "%-22s %8.1f MB/s\n", $1, mb / ($3 - $2) }'
+    grep -q "Kernel TLS is not available" "$DIR/server.log" && echo "    (kernel TLS not available, encrypted in user space)"
+}
+
+echo "$DOWNLOADS downloads of $SIZE_MB MB"
+run plain-http http
+run https-kernel-tls https -c "$DIR/cert.pem" -k "$DIR/key.pem"
+run https-user-space https -c "$DIR/cert.pem" -k "$DIR/key.pem" -s
@@ -0,0 +1,111 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bundle.h"
+
+/**
+ * file bundle.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Packed document root: one file with a hashed path index and the contents of all files.
+ *
+ * @details The bundle is mapped read-only and shared, so the page cache holds its contents only once, no
+ * matter how many processes serve it.
+ **/
+
+uint64_t bundle_hash(const char *path, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char) path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+* @brief checks the header and every used slot of a mapped bundle
+* @param bundle: the bundle with map and size set
+* @return 1 if the bundle is valid and else returns 0
+**/
+static int checkBundle(struct bundle *bundle) {
+    const struct bundle_header *header = (const struct bundle_header *) bundle->map;
+    if (bundle->size < sizeof *header || memcmp(header->magic, BUNDLE_MAGIC, sizeof header->magic) != 0 ||
+        header->version != BUNDLE_VERSION || header->size != bundle->size || header->slotCount == 0 ||
+        (header->slotCount & (header->slotCount - 1)) != 0) {
+        return 0;
+    }
+    uint64_t slotsEnd = sizeof *header + (uint64_t) header->slotCount * sizeof(struct bundle_entry);
+    if (slotsEnd > header->pathsOffset || header->pathsOffset > bundle->size ||
+        header->pathsLen > bundle->size - header->pathsOffset) {
+        return 0;
+    }
+    bundle->header = header;
+    bundle->slots = (const struct bundle_entry *) (bundle->map + sizeof *header);
+    bundle->paths = (const char *) bundle->map + header->pathsOffset;
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < header->slotCount; ++i) {
+        const struct bundle_entry *entry = &bundle->slots[i];
+        used += entry->flags != 0;
+        if (entry->flags != 0 &&
+            (entry->pathOffset > header->pathsLen || entry->pathLen > header->pathsLen - entry->pathOffset ||
+             entry->offset > bundle->size || entry->size > bundle->size - entry->offset)) {
+            return 0;
+        }
+    }
+    return used <= header->slotCount / 2; // bundle_lookup relies on free slots
+}
+
+int bundle_open(struct bundle *bundle, const char *path) {
+    struct stat st;
+    bundle->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (bundle->fd < 0) {
+        return -1;
+    }
+    if (fstat(bundle->fd, &st) < 0) {
+        close(bundle->fd);
+        return -1;
+    }
+    bundle->size = st.st_size;
+    void *map = bundle->size > 0 ? mmap(NULL, bundle->size, PROT_READ, MAP_SHARED, bundle->fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        close(bundle->fd);
+        errno = bundle->size > 0 ? errno : EINVAL;
+        return -1;
+    }
+    bundle->map = map;
+    // requests hit random files, only the index is worth reading ahead
+    posix_madvise(map, bundle->size, POSIX_MADV_RANDOM);
+    if (!checkBundle(bundle)) {
+        bundle_close(bundle);
+        errno = EINVAL;
+        return -1;
+    }
+    posix_madvise(map, bundle->header->dataOffset < bundle->size ? bundle->header->dataOffset : bundle->size,
+                  POSIX_MADV_WILLNEED);
+    return 0;
+}
+
+const struct bundle_entry *bundle_lookup(const struct bundle *bundle, const char *path, size_t len) {
+    uint64_t hash = bundle_hash(path, len);
+    uint32_t mask = bundle->header->slotCount - 1;
+    // the table is at most half full, so a free slot ends every probe sequence
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        const struct bundle_entry *entry = &bundle->slots[i];
+        if (entry->flags == 0) {
+            return NULL;
+        }
+        if (entry->hash == hash && entry->pathLen == len &&
+            memcmp(bundle->paths + entry->pathOffset, path, len) == 0) {
+            return entry;
+        }
+    }
+}
+
+void bundle_close(struct bundle *bundle) {
+    munmap((void *) bundle->map, bundle->size);
+    close(bundle->fd);
+}
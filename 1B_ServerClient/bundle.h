@@ -0,0 +1,93 @@
+/**
+ * file bundle.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Packed document root: one file with a hashed path index and the contents of all files.
+ *
+ * @details A bundle starts with a header, followed by the index, the paths and the contents. The index is
+ * an open addressing hash table with a power of two slots which is at most half full, a path is found with
+ * the slot of its FNV-1a hash and linear probing. Paths are stored normalized and without leading slash
+ * like the server resolves request targets, the document root itself is "". A directory is stored with the
+ * contents of its index file, which is resolved when the bundle is built. Contents of at least one page
+ * start on a page boundary, smaller contents are packed behind each other. Integers are stored in the byte
+ * order of the machine which built the bundle.
+ **/
+
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUNDLE_MAGIC "HTBUNDLE"
+#define BUNDLE_VERSION 1
+#define BUNDLE_PAGE_SIZE 4096
+
+#define BUNDLE_ENTRY_USED 1
+#define BUNDLE_ENTRY_DIRECTORY 2 // the contents are the index file of the directory
+#define BUNDLE_ENTRY_NO_INDEX 4 // a directory without index file, it has no contents
+
+struct bundle_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount; // power of two
+    uint64_t entryCount;
+    uint64_t pathsOffset;
+    uint64_t pathsLen;
+    uint64_t dataOffset;
+    uint64_t size; // size of the whole bundle
+};
+
+struct bundle_entry {
+    uint64_t hash;
+    uint64_t offset; // of the contents from the beginning of the bundle
+    uint64_t size;
+    int64_t modified; // modification time of the file in seconds since the epoch
+    uint64_t pathOffset; // from the beginning of the paths
+    uint32_t pathLen;
+    uint32_t flags; // 0 if the slot is free
+};
+
+struct bundle {
+    int fd;
+    const unsigned char *map;
+    size_t size;
+    const struct bundle_header *header;
+    const struct bundle_entry *slots;
+    const char *paths;
+};
+
+/**
+* @brief hash of a path
+* @param path: the path
+* @param len: length of the path
+* @return the 64 bit FNV-1a hash
+**/
+uint64_t bundle_hash(const char *path, size_t len);
+
+/**
+* @brief map a bundle
+* @details the whole file is mapped, but only the index is read ahead. The header and the index are checked
+* so that no lookup can leave the mapping.
+* @param bundle: set to the mapped bundle
+* @param path: the bundle file
+* @return 0 on success and -1 on error with errno set, EINVAL if the file is no valid bundle
+**/
+int bundle_open(struct bundle *bundle, const char *path);
+
+/**
+* @brief find a path in a bundle
+* @param bundle: the bundle
+* @param path: normalized path without leading slash
+* @param len: length of the path
+* @return the entry or NULL if the path is not in the bundle
+**/
+const struct bundle_entry *bundle_lookup(const struct bundle *bundle, const char *path, size_t len);
+
+/**
+* @brief unmap a bundle and close its file
+* @param bundle: the bundle
+**/
+void bundle_close(struct bundle *bundle);
+
+#endif
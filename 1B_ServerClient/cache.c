@@ -0,0 +1,175 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "bundle.h"
+#include "cache.h"
+
+/**
+ * file cache.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Cache of the proxy mode: objects in files of a cache directory and small objects in memory.
+ *
+ * @details The paths are hashed like the paths of a bundle.
+ **/
+
+void cache_name(const char *path, char name[CACHE_NAME_LEN]) {
+    snprintf(name, CACHE_NAME_LEN, "%016llx", (unsigned long long) bundle_hash(path, strlen(path)));
+}
+
+size_t cache_header(char *out, size_t len, const char *path) {
+    return snprintf(out, len, CACHE_MAGIC " %lu\n%s\n", (unsigned long) strlen(path), path);
+}
+
+int cache_open(int dirFd, const char *path, off_t *base, off_t *size) {
+    char name[CACHE_NAME_LEN];
+    char header[CACHE_MAX_PATH_LEN + 32];
+    size_t headerLen = cache_header(NULL, 0, path);
+    if (headerLen >= sizeof header) {
+        return -1;
+    }
+    cache_name(path, name);
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    char expected[sizeof header];
+    cache_header(expected, sizeof expected, path);
+    // another path with the same hash has another header
+    if (pread(fd, header, headerLen, 0) != (ssize_t) headerLen || memcmp(header, expected, headerLen) != 0 ||
+        fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return -1;
+    }
+    *base = headerLen;
+    *size = st.st_size - headerLen;
+    return fd;
+}
+
+void memory_cache_init(struct memory_cache *cache, size_t limit) {
+    memset(cache, 0, sizeof *cache);
+    cache->limit = limit;
+}
+
+/**
+* @brief finds the link to an object in its slot
+* @param cache: the cache
+* @param path: the path
+* @param hash: hash of the path
+* @return the link which points to the object or to NULL at the end of the slot
+**/
+static struct cache_object **findObject(struct memory_cache *cache, const char *path, uint64_t hash) {
+    size_t pathLen = strlen(path);
+    struct cache_object **link = &cache->heads[hash % MEMORY_CACHE_SLOTS];
+    while (*link != NULL && ((*link)->hash != hash || (*link)->pathLen != pathLen ||
+                             memcmp((*link)->path, path, pathLen) != 0)) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/**
+* @brief takes an object out of the order of use
+* @param cache: the cache
+* @param object: the object
+**/
+static void unlinkObject(struct memory_cache *cache, struct cache_object *object) {
+    if (object->older != NULL) {
+        object->older->newer = object->newer;
+    } else {
+        cache->oldest = object->newer;
+    }
+    if (object->newer != NULL) {
+        object->newer->older = object->older;
+    } else {
+        cache->newest = object->older;
+    }
+}
+
+/**
+* @brief makes an object the most recently used one
+* @param cache: the cache
+* @param object: the object, not in the order of use
+**/
+static void linkNewest(struct memory_cache *cache, struct cache_object *object) {
+    object->older = cache->newest;
+    object->newer = NULL;
+    if (cache->newest != NULL) {
+        cache->newest->newer = object;
+    } else {
+        cache->oldest = object;
+    }
+    cache->newest = object;
+}
+
+/**
+* @brief drops an object
+* @param cache: the cache
+* @param link: the link which points to the object
+**/
+static void dropObject(struct memory_cache *cache, struct cache_object **link) {
+    struct cache_object *object = *link;
+    *link = object->next;
+    unlinkObject(cache, object);
+    cache->used -= object->size;
+    cache->objects--;
+    free(object);
+}
+
+const struct cache_object *memory_cache_get(struct memory_cache *cache, const char *path) {
+    uint64_t hash = bundle_hash(path, strlen(path));
+    struct cache_object *object = *findObject(cache, path, hash);
+    if (object == NULL) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    unlinkObject(cache, object);
+    linkNewest(cache, object);
+    return object;
+}
+
+int memory_cache_put(struct memory_cache *cache, const char *path, const void *data, size_t size) {
+    uint64_t hash = bundle_hash(path, strlen(path));
+    struct cache_object **link = findObject(cache, path, hash);
+    if (*link != NULL) {
+        dropObject(cache, link);
+    }
+    while (cache->oldest != NULL && cache->used + size > cache->limit) {
+        dropObject(cache, findObject(cache, cache->oldest->path, cache->oldest->hash));
+    }
+    if (size > cache->limit) {
+        return -1;
+    }
+
+    size_t pathLen = strlen(path);
+    struct cache_object *object = malloc(sizeof *object + pathLen + 1 + size);
+    if (object == NULL) {
+        return -1;
+    }
+    object->hash = hash;
+    object->pathLen = pathLen;
+    object->size = size;
+    object->path = (char *) (object + 1);
+    object->data = (unsigned char *) object->path + pathLen + 1;
+    memcpy(object->path, path, pathLen + 1);
+    if (size > 0) {
+        memcpy(object->data, data, size);
+    }
+    link = &cache->heads[hash % MEMORY_CACHE_SLOTS];
+    object->next = *link;
+    *link = object;
+    linkNewest(cache, object);
+    cache->used += size;
+    cache->objects++;
+    return 0;
+}
+
+void memory_cache_print_stats(const struct memory_cache *cache, FILE *out) {
+    fprintf(out, "Memory cache: objects %lu, used %lu of %lu bytes, hits %lu, misses %lu\n", cache->objects,
+            (unsigned long) cache->used, (unsigned long) cache->limit, cache->hits, cache->misses);
+}
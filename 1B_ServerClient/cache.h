@@ -0,0 +1,114 @@
+/**
+ * file cache.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Cache of the proxy mode: objects in files of a cache directory and small objects in memory.
+ *
+ * @details An object is the body of a 200 response of the upstream server for a normalized path. On disk
+ * every object is one file in the cache directory, named after the 64 bit FNV-1a hash of its path in hex.
+ * The file starts with a header "HTCACHE1 <path length>\n<path>\n" which tells colliding paths apart,
+ * the body follows directly, so it can be sent with sendfile from the end of the header. Files are written
+ * under a temporary name and renamed when they are complete, a cache file is never half written.
+ * The memory cache holds copies of small bodies in a hash table and drops the least recently used ones
+ * when its limit is reached.
+ **/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#define CACHE_MAGIC "HTCACHE1"
+#define CACHE_NAME_LEN 17 // 16 hex digits and the terminating NUL
+#define CACHE_MAX_PATH_LEN 4096
+#define MEMORY_CACHE_SLOTS 4096
+
+/**
+ * body of one path in the memory cache
+ **/
+struct cache_object {
+    struct cache_object *next; // next object in the same slot
+    struct cache_object *older; // neighbours in the order of use
+    struct cache_object *newer;
+    uint64_t hash;
+    size_t pathLen;
+    size_t size;
+    char *path; // the path and the body are allocated together with the object
+    unsigned char *data;
+};
+
+struct memory_cache {
+    size_t limit; // bytes of all bodies
+    size_t used;
+    unsigned long objects;
+    unsigned long hits;
+    unsigned long misses;
+    struct cache_object *newest;
+    struct cache_object *oldest;
+    struct cache_object *heads[MEMORY_CACHE_SLOTS];
+};
+
+/**
+* @brief file name of the object of a path in the cache directory
+* @param path: normalized path without leading slash
+* @param name: set to the file name
+**/
+void cache_name(const char *path, char name[CACHE_NAME_LEN]);
+
+/**
+* @brief writes the header of a cache file
+* @param out: buffer for the header or NULL to compute only the length
+* @param len: size of the buffer
+* @param path: normalized path without leading slash
+* @return the length of the header, the body starts there
+**/
+size_t cache_header(char *out, size_t len, const char *path);
+
+/**
+* @brief opens the object of a path in the cache directory
+* @param dirFd: the cache directory
+* @param path: normalized path without leading slash
+* @param base: set to the offset of the body in the file
+* @param size: set to the size of the body
+* @return the file descriptor or -1 if the path is not cached
+**/
+int cache_open(int dirFd, const char *path, off_t *base, off_t *size);
+
+/**
+* @brief initialize an empty memory cache
+* @param cache: the cache
+* @param limit: bytes which the bodies may take together
+**/
+void memory_cache_init(struct memory_cache *cache, size_t limit);
+
+/**
+* @brief looks up the body of a path, it becomes the most recently used one
+* @param cache: the cache
+* @param path: normalized path without leading slash
+* @return the object or NULL if the path is not in the cache
+**/
+const struct cache_object *memory_cache_get(struct memory_cache *cache, const char *path);
+
+/**
+* @brief copies the body of a path into the cache
+* @details the least recently used objects are dropped until the body fits, a path which is cached already
+* is replaced
+* @param cache: the cache
+* @param path: normalized path without leading slash
+* @param data: the body
+* @param size: size of the body, at most the limit of the cache
+* @return 0 on success and -1 if no memory is left
+**/
+int memory_cache_put(struct memory_cache *cache, const char *path, const void *data, size_t size);
+
+/**
+* @brief print the statistics of the memory cache
+* @param cache: the cache
+* @param out: stream to which the statistics are written
+**/
+void memory_cache_print_stats(const struct memory_cache *cache, FILE *out);
+
+#endif
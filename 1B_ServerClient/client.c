@@ -1,13 +1,27 @@
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 #include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h> //for exit
 #include <dirent.h>
 #include <errno.h>
+#include <stdint.h>
+#include <getopt.h>
+
+#include "hpack.h"
+#include "http2.h"
+#include "tls.h"
+#include "http1.h"
 /**
  * file client.c
  * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
@@ -21,12 +35,86 @@
  * to specify a filename to which the transmitted content is written. Option -d is used to specify
  * a directory in which a file of the same name as the requested file is created and filled with the
  * transmitted content. If none of these options is given, the transmitted content is written to stdout.
+ * Several URLs can be given, they are fetched one after the other. With option -2 all URLs are fetched
+ * concurrently over one HTTP/2 connection (prior knowledge for http://, ALPN for https://), so they have
+ * to share the scheme and the host. https:// URLs are fetched over TLS, the certificate of the server is
+ * verified against the default trust store or the certificates given with option -c.
+ * Host names are resolved to IPv4 and IPv6 addresses, which are kept for DNS_CACHE_TTL seconds in memory and
+ * in DNS_CACHE_FILE in the home directory, so repeated runs skip the resolver. The addresses are tried
+ * alternately by family in the style of Happy Eyeballs (RFC 8305): a new non-blocking connect is started
+ * every CONNECT_ATTEMPT_DELAY_MS or as soon as an attempt fails and the first established connection
+ * wins. Option -t sets the timeout in milliseconds for the whole connect.
+ * With --stats every fetch records monotonic timestamps of its phases (resolve, connect, TLS handshake,
+ * request sent, first response byte, headers complete, last byte) together with the body bytes and the
+ * throughput. When the client exits they are written as one JSON object to stderr or to the file given
+ * with --stats=FILE, with a summary over all URLs.
  **/
 
 #define BINARY_BUFFER_LEN 1024 * 1024
 #define MAX_CHAR_LEN 2048
+#define HOST_LEN 256 // host name of an URL or an address without brackets
+#define HTTP2_CLIENT_WINDOW (1 << 24)
+#define HTTP2_HEADER_BLOCK_LEN 65536
+#define HTTP2_SEND_FRAME_LEN (HTTP2_FRAME_HEADER_LEN + MAX_CHAR_LEN + 256) // the largest frame is a request
+
+#define DNS_CACHE_TTL 60
+#define DNS_CACHE_FILE ".client_dns_cache"
+#define DNS_CACHE_ENTRIES 32
+#define DNS_MAX_ADDRESSES 8
+#define CONNECT_ATTEMPT_DELAY_MS 250
+#define CONNECT_TIMEOUT_MS 10000
+
+#define STAT_RESOLVE 0
+#define STAT_CONNECT 1
+#define STAT_TLS 2
+#define STAT_REQUEST_SENT 3
+#define STAT_FIRST_BYTE 4
+#define STAT_HEADERS 5
+#define STAT_LAST_BYTE 6
+#define STAT_PHASES 7
 
 static char *program_name;
+static char *caFile; // trusted certificates for https:// URLs or NULL for the default trust store
+static SSL_CTX *tlsContext; // created for the first https:// URL
+static long connectTimeout = CONNECT_TIMEOUT_MS;
+static const char *statNames[STAT_PHASES] = {"resolve", "connect", "tls", "request_sent", "first_byte", "headers",
+                                             "last_byte"};
+static FILE *statsOut; // stream for the JSON statistics or NULL without --stats
+static struct fetch *statFetches; // the URLs whose statistics are written at exit
+static int statCount;
+
+/**
+ * resolved addresses of a host, in the order in which they are tried
+ **/
+struct dns_entry {
+    char host[256];
+    time_t expires;
+    int count;
+    struct sockaddr_storage addresses[DNS_MAX_ADDRESSES]; // the port is set for every connect
+};
+
+static struct dns_entry dnsCache[DNS_CACHE_ENTRIES];
+static int dnsCacheCount = -1; // -1 until the cache file was loaded
+
+/**
+ * one URL which is fetched
+ **/
+struct fetch {
+    char *hostname;
+    char *filename; // path after the host without the leading slash
+    int lastCharIsSlash;
+    int https; // 1 for https:// URLs
+    FILE *out; // file to which the content is written
+    uint32_t streamId; // HTTP/2 stream or 0 if the request was not sent yet
+    long status;
+    int done;
+    long unacknowledged; // received DATA bytes which were not given back with WINDOW_UPDATE
+    int http2; // 1 if the URL is fetched over HTTP/2
+    int dnsCached; // 1 if the addresses of the host came from the DNS cache
+    double start; // monotonic time in milliseconds when the fetch started
+    double times[STAT_PHASES]; // milliseconds after the start or -1 if the phase was not reached
+    long long bytes; // received body bytes
+};
 
 /**
 * @brief checks if Directory exists
@@ -129,51 +217,45 @@ static void checkOptions(int p, int o, int d) {
 }
 
 /**
-* @brief send a request header
-* @details send a request header to the given Host for the a specific file
-* @param sockfile: file for the communication between server and client
-* @param host: host to sent the requested file
-* @param file: file which the client will have
+* @brief returns the monotonic time in milliseconds with microsecond precision
 **/
-static void sendRequestHeader(FILE *sockfile, char *host, char *file) {
-    char requestheader[100] = {0};
-    sprintf(requestheader, "GET /%s HTTP/1.1\r\nHost: "
-                           "%s\r\n"
-                           "Connection: close\r\n\r\n", file, host);
-    fputs(requestheader, sockfile);
-    fflush(sockfile); // send all buffered data
+static double preciseMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
 }
 
 /**
-@brief check the Header from the response
-@details check the Header from the response if the Protocol and the Status code are correct
-@param header_line: first line of the Header
-*/
-static void checkHeader(char *header_line) {
-    char *protocol;
-    protocol = strtok(header_line, " ");
-    char *statusNr;
-    statusNr = strtok(NULL, " ");
-
-    if (strcmp(protocol, "HTTP/1.1") != 0 || isDigitsOnly(statusNr) != 1) {
-        fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
-        exit(EXIT_FAILURE);
+* @brief starts the statistics of a fetch
+* @param fetch: the URL
+**/
+static void startStats(struct fetch *fetch) {
+    fetch->start = preciseMs();
+    for (int i = 0; i < STAT_PHASES; ++i) {
+        fetch->times[i] = -1;
     }
+}
 
-    //print error if Status != 200
-    char *ptr;
-    long statusNumber;
-    statusNumber = strtol(statusNr, &ptr, 10);
-    fprintf(stderr, "Get Response with Status %s\n", statusNr);
-    if (statusNumber != 200) {
-        fprintf(stderr, "Error in %s: %s ", program_name, statusNr);
-        char *status;
-        status = strtok(NULL, " ");
-        while (status != NULL) {
-            fprintf(stderr, "%s ", status);
-            status = strtok(NULL, " ");
-        }
-        fprintf(stderr, "\n");
+/**
+* @brief records the time at which a fetch reached a phase
+* @param fetch: the URL
+* @param phase: one of the STAT_ phases
+**/
+static void markPhase(struct fetch *fetch, int phase) {
+    fetch->times[phase] = preciseMs() - fetch->start;
+}
+
+/**
+@brief check the status line of the response
+@details prints the status, the client exits with 3 if the Status is not 200
+@param response: the status line of the response
+@param fetch: the status of the response is set
+*/
+static void checkHeader(const struct http1_response *response, struct fetch *fetch) {
+    fetch->status = response->status;
+    fprintf(stderr, "Get Response with Status %ld\n", response->status);
+    if (response->status != 200) {
+        fprintf(stderr, "Error in %s: %ld %s\n", program_name, response->status, response->reason);
         exit(3);
     }
 }
@@ -181,19 +263,28 @@ static void checkHeader(char *header_line) {
 /**
 * @brief reads the Header from the response
 * @details reads and check the Header from the response
-* @param sockfile: file for the communication between server and client
+* @param bio: buffered connection to the server
+* @param fetch: the URL, the status and the times of the first byte and the whole header are set
+* @return the Content-Length, HTTP1_BODY_CHUNKED for chunked encoding or HTTP1_BODY_UNTIL_CLOSE
 */
-static void readResponseHeader(FILE *sockfile) {
-    char header_line[2048];
+static long long readResponseHeader(BIO *bio, struct fetch *fetch) {
+    struct http1_response response;
 
     //read html status line and check
-    fgets(header_line, sizeof(header_line), sockfile);
-    checkHeader(header_line);
+    if (http1_read_status_line(bio, &response) < 0) {
+        fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    markPhase(fetch, STAT_FIRST_BYTE);
+    checkHeader(&response, fetch);
 
     //read header line by line until last header line "\r\n"
-    while (strcmp(header_line, "\r\n") != 0) {
-        fgets(header_line, sizeof(header_line), sockfile);
+    if (http1_read_header_fields(bio, &response) < 0) {
+        fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
+        exit(EXIT_FAILURE);
     }
+    markPhase(fetch, STAT_HEADERS);
+    return response.bodyLen;
 }
 
 /**
@@ -225,65 +316,971 @@ static void createDir(char *path, int lastCharIsSlash, char *filename) {
 }
 
 /**
-* @brief  connect to Server
-* @details connect to Server with a specific hostname and Port
-* @param hostname: hostname from the Server
-* @param port: port from the Server
-* @return the value of the socket
-*/
-static int connectToServer(char *hostname, char *port) {
-    struct addrinfo hints;
-    struct addrinfo *result, *rp;
-    int sockfd;
+* @brief returns the monotonic time in milliseconds
+**/
+static long nowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+* @brief get the path of the DNS cache file
+* @param path: buffer for the path
+* @param len: size of the buffer
+* @return 1 if the path was set and 0 if there is no home directory
+**/
+static int getDnsCachePath(char *path, size_t len) {
+    char *home = getenv("HOME");
+    if (home == NULL || *home == '\0') {
+        return 0;
+    }
+    return snprintf(path, len, "%s/%s", home, DNS_CACHE_FILE) < (int) len;
+}
+
+/**
+* @brief parses a numeric IPv4 or IPv6 address
+* @param text: the address
+* @param address: set to the address with port 0
+* @return 1 on success and 0 if the text is no address
+**/
+static int parseAddress(const char *text, struct sockaddr_storage *address) {
+    memset(address, 0, sizeof *address);
+    struct sockaddr_in *in4 = (struct sockaddr_in *) address;
+    struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) address;
+    if (inet_pton(AF_INET, text, &in4->sin_addr) == 1) {
+        in4->sin_family = AF_INET;
+        return 1;
+    }
+    if (inet_pton(AF_INET6, text, &in6->sin6_addr) == 1) {
+        in6->sin6_family = AF_INET6;
+        return 1;
+    }
+    return 0;
+}
 
+/**
+* @brief loads the entries of the DNS cache file which did not expire yet
+* @details every line is "host expires address...", a missing or broken file just leaves the cache empty
+**/
+static void loadDnsCache(void) {
+    dnsCacheCount = 0;
+    char path[MAX_CHAR_LEN];
+    if (!getDnsCachePath(path, sizeof path)) {
+        return;
+    }
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return;
+    }
+    char line[MAX_CHAR_LEN];
+    time_t now = time(NULL);
+    while (dnsCacheCount < DNS_CACHE_ENTRIES && fgets(line, sizeof line, file) != NULL) {
+        struct dns_entry *entry = &dnsCache[dnsCacheCount];
+        char *host = strtok(line, " \n");
+        char *expires = strtok(NULL, " \n");
+        if (host == NULL || expires == NULL || strlen(host) >= sizeof entry->host) {
+            continue;
+        }
+        entry->expires = strtol(expires, NULL, 10);
+        entry->count = 0;
+        char *address;
+        while (entry->count < DNS_MAX_ADDRESSES && (address = strtok(NULL, " \n")) != NULL) {
+            entry->count += parseAddress(address, &entry->addresses[entry->count]);
+        }
+        if (entry->expires > now && entry->count > 0) {
+            strcpy(entry->host, host);
+            dnsCacheCount++;
+        }
+    }
+    fclose(file);
+}
 
-    /* Obtain address(es) matching host/port */
+/**
+* @brief writes the DNS cache to the cache file
+* @details the file is replaced atomically, so concurrent clients never read a half written file
+**/
+static void saveDnsCache(void) {
+    char path[MAX_CHAR_LEN];
+    char tmpPath[MAX_CHAR_LEN + 32];
+    if (!getDnsCachePath(path, sizeof path)) {
+        return;
+    }
+    snprintf(tmpPath, sizeof tmpPath, "%s.%ld", path, (long) getpid());
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (file == NULL) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    for (int i = 0; i < dnsCacheCount; ++i) {
+        fprintf(file, "%s %ld", dnsCache[i].host, (long) dnsCache[i].expires);
+        for (int j = 0; j < dnsCache[i].count; ++j) {
+            char text[INET6_ADDRSTRLEN];
+            struct sockaddr_storage *address = &dnsCache[i].addresses[j];
+            const void *raw = address->ss_family == AF_INET
+                              ? (const void *) &((struct sockaddr_in *) address)->sin_addr
+                              : (const void *) &((struct sockaddr_in6 *) address)->sin6_addr;
+            fprintf(file, " %s", inet_ntop(address->ss_family, raw, text, sizeof text));
+        }
+        fprintf(file, "\n");
+    }
+    if (fclose(file) == 0) {
+        rename(tmpPath, path);
+    } else {
+        unlink(tmpPath);
+    }
+}
+
+/**
+* @brief looks a host up in the DNS cache
+* @param host: the host
+* @return the entry or NULL if the host is not cached or the entry expired
+**/
+static struct dns_entry *lookupDnsCache(const char *host) {
+    if (dnsCacheCount < 0) {
+        loadDnsCache();
+    }
+    time_t now = time(NULL);
+    for (int i = 0; i < dnsCacheCount; ++i) {
+        if (strcmp(dnsCache[i].host, host) == 0 && dnsCache[i].expires > now) {
+            return &dnsCache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+* @brief resolves a host and stores the addresses in the DNS cache
+* @details the addresses are sorted by getaddrinfo (RFC 6724) and then interleaved by family, so a broken
+* IPv6 or IPv4 path costs at most one attempt delay
+* @param host: the host
+* @return the entry, the program exits if the host cannot be resolved
+**/
+static struct dns_entry *resolveHost(const char *host) {
+    struct addrinfo hints;
+    struct addrinfo *result, *rp;
     memset(&hints, 0, sizeof(struct addrinfo));
-    hints.ai_family = AF_INET;
+    hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags = 0;
-    hints.ai_protocol = 0;          /* Any protocol */
-
+    hints.ai_flags = AI_ADDRCONFIG;
 
-    int res = getaddrinfo(hostname, port, &hints, &result);
+    int res = getaddrinfo(host, NULL, &hints, &result);
     if (res != 0) {
         fprintf(stderr, "Error in %s: getaddrinfo: %s\n", program_name, gai_strerror(res));
         exit(EXIT_FAILURE);
     }
 
-    for (rp = result; rp != NULL; rp = rp->ai_next) {
-        sockfd = socket(rp->ai_family, rp->ai_socktype,
-                        rp->ai_protocol);
-        if (sockfd == -1)
+    if (dnsCacheCount < 0) {
+        loadDnsCache();
+    }
+    struct dns_entry *entry = NULL;
+    for (int i = 0; i < dnsCacheCount; ++i) { // replace the old entry of the host or the one which expires first
+        if (strcmp(dnsCache[i].host, host) == 0) {
+            entry = &dnsCache[i];
+            break;
+        }
+        if (entry == NULL || dnsCache[i].expires < entry->expires) {
+            entry = &dnsCache[i];
+        }
+    }
+    if (dnsCacheCount < DNS_CACHE_ENTRIES && (entry == NULL || strcmp(entry->host, host) != 0)) {
+        entry = &dnsCache[dnsCacheCount++];
+    }
+    snprintf(entry->host, sizeof entry->host, "%s", host);
+    entry->expires = time(NULL) + DNS_CACHE_TTL;
+    entry->count = 0;
+
+    int firstFamily = result->ai_family;
+    for (int pass = 0; pass < DNS_MAX_ADDRESSES && entry->count < DNS_MAX_ADDRESSES; ++pass) {
+        int added = 0;
+        for (int family = 0; family < 2; ++family) {
+            int wanted = family == 0 ? firstFamily : (firstFamily == AF_INET ? AF_INET6 : AF_INET);
+            int index = 0;
+            for (rp = result; rp != NULL; rp = rp->ai_next) {
+                if (rp->ai_family != wanted || rp->ai_addrlen > sizeof(struct sockaddr_storage)) {
+                    continue;
+                }
+                if (index++ == pass && entry->count < DNS_MAX_ADDRESSES) {
+                    memcpy(&entry->addresses[entry->count++], rp->ai_addr, rp->ai_addrlen);
+                    added = 1;
+                    break;
+                }
+            }
+        }
+        if (!added) {
+            break;
+        }
+    }
+    freeaddrinfo(result);
+    saveDnsCache();
+    return entry;
+}
+
+/**
+* @brief races connects to the addresses of a host
+* @details a new attempt starts every CONNECT_ATTEMPT_DELAY_MS or at once when an attempt failed, the first
+* established connection is kept and all other attempts are closed
+* @param entry: addresses of the host
+* @param port: port from the Server
+* @return the blocking socket or -1 if no address could be connected within the timeout
+**/
+static int connectHappyEyeballs(struct dns_entry *entry, int port) {
+    struct pollfd attempts[DNS_MAX_ADDRESSES];
+    int started = 0;
+    int active = 0;
+    int sockfd = -1;
+    long deadline = nowMs() + connectTimeout;
+    long nextAttempt = 0;
+
+    while (sockfd < 0) {
+        long now = nowMs();
+        if (now >= deadline) {
+            break;
+        }
+        if (started < entry->count && (active == 0 || now >= nextAttempt)) {
+            struct sockaddr_storage address = entry->addresses[started++];
+            socklen_t addressLen;
+            if (address.ss_family == AF_INET) {
+                ((struct sockaddr_in *) &address)->sin_port = htons(port);
+                addressLen = sizeof(struct sockaddr_in);
+            } else {
+                ((struct sockaddr_in6 *) &address)->sin6_port = htons(port);
+                addressLen = sizeof(struct sockaddr_in6);
+            }
+            int fd = socket(address.ss_family, SOCK_STREAM, 0);
+            if (fd < 0) {
+                continue;
+            }
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            if (connect(fd, (struct sockaddr *) &address, addressLen) == 0) {
+                sockfd = fd;
+            } else if (errno == EINPROGRESS) {
+                attempts[active].fd = fd;
+                attempts[active].events = POLLOUT;
+                active++;
+                nextAttempt = now + CONNECT_ATTEMPT_DELAY_MS;
+            } else {
+                close(fd); // e.g. no route for this family, go on with the next address at once
+            }
             continue;
+        }
+        if (active == 0) { // every address failed
+            break;
+        }
 
-        if (connect(sockfd, rp->ai_addr, rp->ai_addrlen) != -1)
-            break;                  /* Success */
+        long wait = deadline - now;
+        if (started < entry->count && nextAttempt - now < wait) {
+            wait = nextAttempt - now;
+        }
+        if (poll(attempts, active, wait) < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < active && sockfd < 0;) {
+            if (attempts[i].revents == 0) {
+                i++;
+                continue;
+            }
+            int error = 0;
+            socklen_t errorLen = sizeof error;
+            getsockopt(attempts[i].fd, SOL_SOCKET, SO_ERROR, &error, &errorLen);
+            if (error == 0) {
+                sockfd = attempts[i].fd;
+            } else {
+                close(attempts[i].fd);
+                nextAttempt = now;
+            }
+            attempts[i] = attempts[--active];
+        }
+    }
+
+    for (int i = 0; i < active; ++i) {
+        close(attempts[i].fd);
+    }
+    if (sockfd >= 0) { // the connection is used with blocking reads and writes
+        fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) & ~O_NONBLOCK);
+    }
+    return sockfd;
+}
+
+/**
+* @brief copies the host of an URL without the brackets around an IPv6 address
+* @param fetch: the URL
+* @param host: set to the host name or address
+*/
+static void copyHost(const struct fetch *fetch, char host[HOST_LEN]) {
+    const char *hostname = fetch->hostname;
+    size_t hostLen = strlen(hostname);
+    if (hostname[0] == '[' && hostLen >= 2 && hostname[hostLen - 1] == ']') {
+        hostLen -= 2;
+        hostname++;
     }
+    if (hostLen >= HOST_LEN) {
+        fprintf(stderr, "Error in %s: Host name too long\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(host, hostname, hostLen);
+    host[hostLen] = '\0';
+}
+
+/**
+* @brief  connect to Server
+* @details connect to Server with a specific hostname and Port, cached addresses which do not work any more
+* are resolved again once
+* @param fetch: the URL, its hostname may be an IPv6 address in brackets
+* @param port: port from the Server
+* @return the value of the socket
+*/
+static int connectToServer(struct fetch *fetch, char *port) {
+    char host[HOST_LEN];
+    copyHost(fetch, host);
 
-    if (rp == NULL) {               /* No address succeeded */
+    struct dns_entry numeric;
+    struct dns_entry *entry = &numeric;
+    int cached = 0;
+    if (parseAddress(host, &numeric.addresses[0])) { // nothing to resolve or cache
+        numeric.count = 1;
+    } else {
+        entry = lookupDnsCache(host);
+        cached = entry != NULL;
+        if (!cached) {
+            entry = resolveHost(host);
+        }
+    }
+    fetch->dnsCached = cached;
+    markPhase(fetch, STAT_RESOLVE);
+    int sockfd = connectHappyEyeballs(entry, atoi(port));
+    if (sockfd < 0 && cached) {
+        fetch->dnsCached = 0;
+        sockfd = connectHappyEyeballs(resolveHost(host), atoi(port));
+    }
 
+    if (sockfd < 0) {               /* No address succeeded */
         fprintf(stderr, "Error in %s: Could not connect\n", program_name);
         exit(EXIT_FAILURE);
     }
-    freeaddrinfo(result);
+    markPhase(fetch, STAT_CONNECT);
     return sockfd;
+}
 
+/**
+* @brief opens a connection for an URL
+* @details for https:// URLs the TLS handshake is done and the certificate of the server is verified
+* @param fetch: the URL
+* @param port: port from the Server
+* @param http2: 1 to ask for HTTP/2 with ALPN
+* @return the connection
+*/
+static BIO *openConnection(struct fetch *fetch, char *port, int http2) {
+    int sockfd = connectToServer(fetch, port);
+    // every request and frame is written in one piece, so Nagle would only wait for the delayed ACK
+    int nodelay = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof nodelay);
+    BIO *bio = BIO_new_socket(sockfd, BIO_CLOSE);
+    if (!fetch->https) {
+        return bio;
+    }
 
+    if (tlsContext == NULL) {
+        tlsContext = tls_client_context(caFile);
+        if (tlsContext == NULL) {
+            tls_print_errors(program_name);
+            fprintf(stderr, "Error in %s: Could not load trusted certificates\n", program_name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    BIO *sslBio = BIO_new_ssl(tlsContext, 1);
+    SSL *ssl;
+    BIO_get_ssl(sslBio, &ssl);
+    char host[HOST_LEN];
+    struct sockaddr_storage address;
+    copyHost(fetch, host);
+    if (parseAddress(host, &address)) { // SNI carries no addresses, the certificate has to name the address
+        X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), host);
+    } else {
+        SSL_set_tlsext_host_name(ssl, host);
+        SSL_set1_host(ssl, host);
+    }
+    SSL_set_alpn_protos(ssl, (const unsigned char *) (http2 ? "\x02h2" : "\x08http/1.1"), http2 ? 3 : 9);
+    bio = BIO_push(sslBio, bio);
+
+    if (BIO_do_handshake(bio) != 1) {
+        tls_print_errors(program_name);
+        fprintf(stderr, "Error in %s: TLS handshake with %s failed\n", program_name, fetch->hostname);
+        exit(EXIT_FAILURE);
+    }
+    markPhase(fetch, STAT_TLS);
+    const unsigned char *protocol;
+    unsigned int protocolLen;
+    SSL_get0_alpn_selected(ssl, &protocol, &protocolLen);
+    if (http2 && (protocolLen != 2 || memcmp(protocol, "h2", 2) != 0)) {
+        fprintf(stderr, "Error in %s: %s does not speak HTTP/2 over TLS\n", program_name, fetch->hostname);
+        exit(EXIT_FAILURE);
+    }
+    return bio;
 }
 
+/**
+* @brief writes a piece of the body to the output file, called by http1_read_body
+* @param context: the URL, the piece is counted
+* @param data: the bytes
+* @param len: number of bytes
+* @return always 0
+*/
+static int writeBody(void *context, const void *data, size_t len) {
+    struct fetch *fetch = context;
+    fwrite(data, sizeof(uint8_t), len, fetch->out);
+    fetch->bytes += len;
+    return 0;
+}
 
 /**
 * @brief get response File
-* @details get response File and save it to stdout
-* @param hostname: hostname from the Server
-* @param sockfile: file for the communication between server and client
+* @details get response File and save it to the output file. A chunked body is decoded while it arrives,
+* every chunk is copied to the output file piece by piece and never buffered as a whole.
+* @param bio: buffered connection to the server
+* @param fetch: the URL, the content is written to its output file
+* @param bodyLen: the result of readResponseHeader
 */
-static void getResponseFile(FILE *sockfile) {
-    uint8_t binary_buffer[BINARY_BUFFER_LEN];
-    while (!feof(sockfile)) {
-        ssize_t n = fread(binary_buffer, sizeof(uint8_t), BINARY_BUFFER_LEN, sockfile);
-        fwrite(binary_buffer, sizeof(uint8_t), n, stdout);
+static void getResponseFile(BIO *bio, struct fetch *fetch, long long bodyLen) {
+    static uint8_t binary_buffer[BINARY_BUFFER_LEN];
+    int complete = http1_read_body(bio, bodyLen, binary_buffer, sizeof binary_buffer, writeBody, fetch);
+    if (complete < 0) {
+        fprintf(stderr, "Error in %s: Protocol error! Invalid chunk size\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    if (!complete) {
+        fprintf(stderr, "Error in %s: Connection closed before the end of the response\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    markPhase(fetch, STAT_LAST_BYTE);
+}
+
+/**
+* @brief splits an URL into scheme, hostname and filename
+* @details the URL is changed in place, the program exits if the URL is invalid
+* @param url: the URL
+* @param fetch: https, hostname, filename and lastCharIsSlash are set
+*/
+static void parseUrl(char *url, struct fetch *fetch) {
+    fetch->lastCharIsSlash = checkLastCharIsSlash(url);
+    char *http = "http://";
+    char *https = "https://";
+
+    if (strncmp(url, http, strlen(http)) == 0) {
+        fetch->https = 0;
+        url += strlen(http);
+    } else if (strncmp(url, https, strlen(https)) == 0) {
+        fetch->https = 1;
+        url += strlen(https);
+    } else {
+        fprintf(stderr, "Error in %s: Invalid Url\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+
+    int delimiterPos = -1;
+    int hostStart = 0;
+    if (url[0] == '[') { // IPv6 address, the colons inside the brackets are no delimiters
+        char *end = strchr(url, ']');
+        hostStart = end != NULL ? end - url : 0;
+    }
+    for (int i = hostStart; i < strlen(url); ++i) {
+        if (url[i] == '/' ||
+            url[i] == ';' ||
+            url[i] == '?' ||
+            url[i] == ':' ||
+            url[i] == '@' ||
+            url[i] == '=' ||
+            url[i] == '&'
+                ) {
+            delimiterPos = i;
+            break;
+        }
+    }
+
+    if (delimiterPos == -1) {
+        fprintf(stderr, "Error in %s: Invalid Url\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    fetch->filename = url + delimiterPos + 1;
+    fetch->hostname = url;
+    fetch->hostname[delimiterPos] = '\0';
+}
+
+/**
+* @brief opens the file to which the content of an URL is written
+* @param fetch: the URL
+* @param dir: output directory or NULL
+*/
+static FILE *openOutput(struct fetch *fetch, char *dir) {
+    if (dir == NULL) {
+        return stdout;
+    }
+    if (!checkDirExists(dir)) {
+        fprintf(stderr, "Error in %s: Directory does not exist\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    char *pathWithFilename = malloc(strlen(dir) + strlen(fetch->filename) + strlen("/index.html") + 1);
+    if (pathWithFilename == NULL) {
+        fprintf(stderr, "Error in %s: malloc failed\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    strcpy(pathWithFilename, dir);
+    createDir(pathWithFilename, fetch->lastCharIsSlash, fetch->filename);
+    FILE *out = fopen(pathWithFilename, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Error in %s: Output File not open\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    free(pathWithFilename);
+    return out;
+}
+
+/**
+* @brief fetch an URL with HTTP/1.1
+* @param fetch: the URL
+* @param port: port from the Server
+*/
+static void fetchHttp1(struct fetch *fetch, char *port) {
+    startStats(fetch);
+    BIO *bio = BIO_push(BIO_new(BIO_f_buffer()), openConnection(fetch, port, 0));
+
+    http1_send_request(bio, fetch->hostname, fetch->filename);
+    markPhase(fetch, STAT_REQUEST_SENT);
+    long long bodyLen = readResponseHeader(bio, fetch);
+    getResponseFile(bio, fetch, bodyLen);
+
+    BIO_free_all(bio);
+}
+
+/**
+* @brief writes all bytes to the server
+* @param bio: connection to the server
+* @param buffer: the bytes
+* @param len: number of bytes
+*/
+static void writeAll(BIO *bio, const void *buffer, size_t len) {
+    const char *pos = buffer;
+    while (len > 0) {
+        int n = BIO_write(bio, pos, len);
+        if (n <= 0) {
+            fprintf(stderr, "Error in %s: write failed\n", program_name);
+            exit(EXIT_FAILURE);
+        }
+        pos += n;
+        len -= n;
+    }
+}
+
+/**
+* @brief reads exactly len bytes from the server
+* @param bio: connection to the server
+* @param buffer: buffer for the bytes
+* @param len: number of bytes
+*/
+static void readAll(BIO *bio, void *buffer, size_t len) {
+    char *pos = buffer;
+    while (len > 0) {
+        int n = BIO_read(bio, pos, len);
+        if (n <= 0) {
+            fprintf(stderr, "Error in %s: Connection closed by the server\n", program_name);
+            exit(EXIT_FAILURE);
+        }
+        pos += n;
+        len -= n;
+    }
+}
+
+/**
+* @brief sends a HTTP/2 frame
+* @details the header and the payload are written together, a frame never waits for the ACK of its header
+* @param bio: connection to the server
+* @param type: type of the frame
+* @param flags: flags of the frame
+* @param streamId: stream of the frame
+* @param payload: payload of the frame
+* @param len: length of the payload
+*/
+static void sendFrame(BIO *bio, uint8_t type, uint8_t flags, uint32_t streamId, const void *payload, size_t len) {
+    unsigned char frame[HTTP2_SEND_FRAME_LEN];
+    if (len > sizeof frame - HTTP2_FRAME_HEADER_LEN) {
+        fprintf(stderr, "Error in %s: HTTP/2 frame too large\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    http2_write_frame_header(frame, len, type, flags, streamId);
+    if (len > 0) {
+        memcpy(frame + HTTP2_FRAME_HEADER_LEN, payload, len);
+    }
+    writeAll(bio, frame, HTTP2_FRAME_HEADER_LEN + len);
+}
+
+/**
+* @brief sends a WINDOW_UPDATE frame
+* @param bio: connection to the server
+* @param streamId: stream of the frame or 0 for the connection
+* @param increment: bytes which are added to the window
+*/
+static void sendWindowUpdate(BIO *bio, uint32_t streamId, uint32_t increment) {
+    unsigned char payload[4];
+    http2_put32(payload, increment);
+    sendFrame(bio, HTTP2_WINDOW_UPDATE, 0, streamId, payload, sizeof payload);
+}
+
+/**
+* @brief sends the request of an URL on a new HTTP/2 stream
+* @param bio: connection to the server
+* @param fetch: the URL
+* @param streamId: the new stream
+* @param authority: host and port of the Server
+*/
+static void sendHttp2Request(BIO *bio, struct fetch *fetch, uint32_t streamId, char *authority) {
+    unsigned char block[MAX_CHAR_LEN + 256];
+    char path[MAX_CHAR_LEN];
+    snprintf(path, sizeof path, "/%s", fetch->filename);
+
+    size_t len = hpack_encode(block, sizeof block, ":method", "GET");
+    len += hpack_encode(block + len, sizeof block - len, ":scheme", fetch->https ? "https" : "http");
+    len += hpack_encode(block + len, sizeof block - len, ":authority", authority);
+    size_t pathLen = hpack_encode(block + len, sizeof block - len, ":path", path);
+    if (pathLen == 0) {
+        fprintf(stderr, "Error in %s: Url too long\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    len += pathLen;
+
+    fprintf(stderr, "Send Request for %s://%s/%s on HTTP/2 stream %lu\n", fetch->https ? "https" : "http",
+            fetch->hostname, fetch->filename,
+            (unsigned long) streamId);
+    sendFrame(bio, HTTP2_HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, streamId, block, len);
+    markPhase(fetch, STAT_REQUEST_SENT);
+    fetch->streamId = streamId;
+}
+
+/**
+* @brief stores the status of a response, called by the HPACK decoder
+* @param context: the fetch of the stream
+* @param name: name of the header field
+* @param nameLen: length of the name
+* @param value: value of the header field
+* @param valueLen: length of the value
+*/
+static void responseHeader(void *context, const char *name, size_t nameLen, const char *value, size_t valueLen) {
+    struct fetch *fetch = context;
+    if (nameLen == strlen(":status") && memcmp(name, ":status", nameLen) == 0 && valueLen < 8) {
+        char status[8];
+        memcpy(status, value, valueLen);
+        status[valueLen] = '\0';
+        fetch->status = isDigitsOnly(status) ? strtol(status, NULL, 10) : 0;
+    }
+}
+
+/**
+* @brief finishes the stream of an URL
+* @param fetch: the URL
+* @param status: status which is reported, the status of the response if it is 200
+* @return 1 if the response has the status 200 and else returns 0
+*/
+static int finishFetch(struct fetch *fetch, long status) {
+    fetch->done = 1;
+    markPhase(fetch, STAT_LAST_BYTE);
+    if (status == 200) {
+        return 1;
+    }
+    fprintf(stderr, "Error in %s: %s/%s: %ld\n", program_name, fetch->hostname, fetch->filename, status);
+    return 0;
+}
+
+/**
+* @brief fetch all URLs concurrently over one HTTP/2 connection
+* @details the requests are sent as fast as the MAX_CONCURRENT_STREAMS of the server allow, the frames of
+* all responses are read from the same connection and written to the output file of their stream
+* @param fetches: the URLs
+* @param count: number of URLs
+* @param port: port from the Server
+* @return 1 if all responses have the status 200 and else returns 0
+*/
+static int fetchHttp2(struct fetch *fetches, int count, char *port) {
+    static unsigned char payload[HTTP2_DEFAULT_FRAME_SIZE];
+    static unsigned char headerBlock[HTTP2_HEADER_BLOCK_LEN];
+    size_t headerBlockLen = 0;
+    struct fetch *headerFetch = NULL;
+    struct hpack_table decoder;
+    hpack_table_init(&decoder);
+
+    char authority[MAX_CHAR_LEN];
+    snprintf(authority, sizeof authority, "%s:%s", fetches[0].hostname, port);
+    startStats(&fetches[0]);
+    BIO *bio = openConnection(&fetches[0], port, 1);
+    for (int i = 0; i < count; ++i) { // all URLs share the connection and its setup
+        fetches[i].http2 = 1;
+        fetches[i].start = fetches[0].start;
+        fetches[i].dnsCached = fetches[0].dnsCached;
+        memcpy(fetches[i].times, fetches[0].times, sizeof fetches[i].times);
+    }
+
+    // connection preface, the windows are large enough that the server is never blocked by the client
+    writeAll(bio, HTTP2_PREFACE, HTTP2_PREFACE_LEN);
+    unsigned char settings[12];
+    size_t settingsLen = http2_write_setting(settings, HTTP2_SETTINGS_ENABLE_PUSH, 0);
+    settingsLen += http2_write_setting(settings + settingsLen, HTTP2_SETTINGS_INITIAL_WINDOW_SIZE,
+                                       HTTP2_CLIENT_WINDOW);
+    sendFrame(bio, HTTP2_SETTINGS, 0, 0, settings, settingsLen);
+    sendWindowUpdate(bio, 0, HTTP2_CLIENT_WINDOW - HTTP2_DEFAULT_WINDOW);
+
+    long maxStreams = -1; // unknown until the SETTINGS of the server arrived
+    long connectionUnacknowledged = 0;
+    int active = 0;
+    int next = 0;
+    int finished = 0;
+    int success = 1;
+    uint32_t nextStreamId = 1;
+
+    while (finished < count) {
+        while (maxStreams >= 0 && next < count && active < maxStreams) {
+            sendHttp2Request(bio, &fetches[next], nextStreamId, authority);
+            nextStreamId += 2;
+            next++;
+            active++;
+        }
+
+        unsigned char header[HTTP2_FRAME_HEADER_LEN];
+        struct http2_frame frame;
+        readAll(bio, header, sizeof header);
+        http2_read_frame_header(header, &frame);
+        if (frame.length > sizeof payload) {
+            fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
+            exit(EXIT_FAILURE);
+        }
+        readAll(bio, payload, frame.length);
+
+        struct fetch *fetch = NULL;
+        for (int i = 0; i < next && frame.streamId != 0; ++i) {
+            if (fetches[i].streamId == frame.streamId && !fetches[i].done) {
+                fetch = &fetches[i];
+            }
+        }
+        if (fetch != NULL && fetch->times[STAT_FIRST_BYTE] < 0) {
+            markPhase(fetch, STAT_FIRST_BYTE);
+        }
+
+        const unsigned char *data = payload;
+        size_t len;
+        switch (frame.type) {
+            case HTTP2_SETTINGS:
+                if (!(frame.flags & HTTP2_FLAG_ACK)) {
+                    if (maxStreams < 0) {
+                        maxStreams = count;
+                    }
+                    for (size_t i = 0; i + 6 <= frame.length; i += 6) {
+                        if (((payload[i] << 8) | payload[i + 1]) == HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS) {
+                            maxStreams = http2_get32(payload + i + 2);
+                        }
+                    }
+                    sendFrame(bio, HTTP2_SETTINGS, HTTP2_FLAG_ACK, 0, NULL, 0);
+                }
+                break;
+            case HTTP2_PING:
+                if (!(frame.flags & HTTP2_FLAG_ACK)) {
+                    sendFrame(bio, HTTP2_PING, HTTP2_FLAG_ACK, 0, payload, frame.length);
+                }
+                break;
+            case HTTP2_HEADERS:
+            case HTTP2_CONTINUATION:
+                if (frame.type == HTTP2_HEADERS) {
+                    if (http2_strip_padding(&frame, &data, &len) < 0) {
+                        fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
+                        exit(EXIT_FAILURE);
+                    }
+                    headerBlockLen = 0;
+                    headerFetch = fetch;
+                } else {
+                    len = frame.length;
+                }
+                if (len > sizeof headerBlock - headerBlockLen) {
+                    fprintf(stderr, "Error in %s: Response header too large\n", program_name);
+                    exit(EXIT_FAILURE);
+                }
+                memcpy(headerBlock + headerBlockLen, data, len);
+                headerBlockLen += len;
+                if (frame.flags & HTTP2_FLAG_END_HEADERS) {
+                    // the block is decoded even for unknown streams to keep the dynamic table in sync
+                    struct fetch unknown;
+                    struct fetch *target = headerFetch != NULL ? headerFetch : &unknown;
+                    if (hpack_decode(&decoder, headerBlock, headerBlockLen, responseHeader, target) < 0) {
+                        fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
+                        exit(EXIT_FAILURE);
+                    }
+                    if (headerFetch != NULL) {
+                        markPhase(headerFetch, STAT_HEADERS);
+                    }
+                    if (headerFetch != NULL && headerFetch->status != 0) {
+                        fprintf(stderr, "Get Response with Status %ld on HTTP/2 stream %lu\n", headerFetch->status,
+                                (unsigned long) headerFetch->streamId);
+                    }
+                }
+                if (fetch != NULL && (frame.flags & HTTP2_FLAG_END_STREAM)) {
+                    success &= finishFetch(fetch, fetch->status);
+                    finished++;
+                    active--;
+                }
+                break;
+            case HTTP2_DATA:
+                if (http2_strip_padding(&frame, &data, &len) < 0) {
+                    fprintf(stderr, "Error in %s: Protocol error! \n", program_name);
+                    exit(EXIT_FAILURE);
+                }
+                connectionUnacknowledged += frame.length;
+                if (connectionUnacknowledged >= HTTP2_CLIENT_WINDOW / 2) {
+                    sendWindowUpdate(bio, 0, connectionUnacknowledged);
+                    connectionUnacknowledged = 0;
+                }
+                if (fetch == NULL) {
+                    break;
+                }
+                if (fetch->status == 200) {
+                    fwrite(data, 1, len, fetch->out);
+                }
+                fetch->bytes += len;
+                fetch->unacknowledged += frame.length;
+                if (frame.flags & HTTP2_FLAG_END_STREAM) {
+                    success &= finishFetch(fetch, fetch->status);
+                    finished++;
+                    active--;
+                } else if (fetch->unacknowledged >= HTTP2_CLIENT_WINDOW / 2) {
+                    sendWindowUpdate(bio, fetch->streamId, fetch->unacknowledged);
+                    fetch->unacknowledged = 0;
+                }
+                break;
+            case HTTP2_RST_STREAM:
+                if (fetch != NULL) {
+                    fprintf(stderr, "Error in %s: Stream %lu was reset\n", program_name,
+                            (unsigned long) frame.streamId);
+                    success &= finishFetch(fetch, 0);
+                    finished++;
+                    active--;
+                }
+                break;
+            case HTTP2_GOAWAY:
+                fprintf(stderr, "Error in %s: Connection closed by the server\n", program_name);
+                exit(EXIT_FAILURE);
+            default:
+                break;
+        }
+    }
+
+    unsigned char goaway[8];
+    http2_put32(goaway, 0);
+    http2_put32(goaway + 4, HTTP2_NO_ERROR);
+    sendFrame(bio, HTTP2_GOAWAY, 0, 0, goaway, sizeof goaway);
+    BIO_free_all(bio);
+    return success;
+}
+
+/**
+* @brief writes a string as JSON string
+* @param out: the stream
+* @param str: the string
+*/
+static void writeJsonString(FILE *out, const char *str) {
+    putc('"', out);
+    for (const unsigned char *c = (const unsigned char *) str; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            putc(*c, out);
+        }
+    }
+    putc('"', out);
+}
+
+/**
+* @brief writes a time of the statistics
+* @param out: the stream
+* @param ms: milliseconds or a negative value if the time is unknown
+*/
+static void writeJsonTime(FILE *out, double ms) {
+    if (ms < 0) {
+        fprintf(out, "null");
+    } else {
+        fprintf(out, "%.3f", ms);
+    }
+}
+
+/**
+* @brief writes the statistics of all URLs as JSON
+* @details called at exit, so URLs which were fetched before an error are reported as well. The times of
+* the phases are milliseconds after the start of the fetch, the summary has their minimum, average and
+* maximum over the URLs which reached the phase.
+*/
+static void writeStats(void) {
+    double first = -1;
+    double last = -1;
+    long long totalBytes = 0;
+    int completed = 0;
+
+    fprintf(statsOut, "{\"urls\": [");
+    for (int i = 0; i < statCount; ++i) {
+        struct fetch *fetch = &statFetches[i];
+        char url[MAX_CHAR_LEN * 2];
+        snprintf(url, sizeof url, "%s://%s/%s", fetch->https ? "https" : "http", fetch->hostname, fetch->filename);
+        fprintf(statsOut, "%s\n  {\"url\": ", i > 0 ? "," : "");
+        writeJsonString(statsOut, url);
+        fprintf(statsOut, ", \"protocol\": \"%s\", \"status\": %ld, \"dns_cached\": %s, \"bytes\": %lld, \"times_ms\": {",
+                fetch->http2 ? "h2" : "http/1.1", fetch->status, fetch->dnsCached ? "true" : "false", fetch->bytes);
+        for (int phase = 0; phase < STAT_PHASES; ++phase) {
+            fprintf(statsOut, "%s\"%s\": ", phase > 0 ? ", " : "", statNames[phase]);
+            writeJsonTime(statsOut, fetch->start > 0 ? fetch->times[phase] : -1);
+        }
+        double total = fetch->start > 0 ? fetch->times[STAT_LAST_BYTE] : -1;
+        fprintf(statsOut, "}, \"bytes_per_second\": ");
+        writeJsonTime(statsOut, total > 0 ? fetch->bytes * 1000.0 / total : -1);
+        fprintf(statsOut, "}");
+
+        if (fetch->start > 0) {
+            first = first < 0 || fetch->start < first ? fetch->start : first;
+            double end = fetch->start + (total >= 0 ? total : 0);
+            last = end > last ? end : last;
+        }
+        totalBytes += fetch->bytes;
+        completed += total >= 0 && fetch->status == 200;
+    }
+
+    double elapsed = first >= 0 ? last - first : -1;
+    fprintf(statsOut, "\n],\n\"summary\": {\"urls\": %d, \"completed\": %d, \"bytes\": %lld, \"elapsed_ms\": ",
+            statCount, completed, totalBytes);
+    writeJsonTime(statsOut, elapsed);
+    fprintf(statsOut, ", \"bytes_per_second\": ");
+    writeJsonTime(statsOut, elapsed > 0 ? totalBytes * 1000.0 / elapsed : -1);
+    fprintf(statsOut, ", \"times_ms\": {");
+    for (int phase = 0; phase < STAT_PHASES; ++phase) {
+        double min = -1, max = -1, sum = 0;
+        int n = 0;
+        for (int i = 0; i < statCount; ++i) {
+            double t = statFetches[i].start > 0 ? statFetches[i].times[phase] : -1;
+            if (t >= 0) {
+                min = min < 0 || t < min ? t : min;
+                max = t > max ? t : max;
+                sum += t;
+                n++;
+            }
+        }
+        fprintf(statsOut, "%s\n  \"%s\": {\"count\": %d, \"min\": ", phase > 0 ? "," : "", statNames[phase], n);
+        writeJsonTime(statsOut, min);
+        fprintf(statsOut, ", \"avg\": ");
+        writeJsonTime(statsOut, n > 0 ? sum / n : -1);
+        fprintf(statsOut, ", \"max\": ");
+        writeJsonTime(statsOut, max);
+        fprintf(statsOut, "}");
+    }
+    fprintf(statsOut, "\n}}}\n");
+    if (statsOut != stderr) {
+        fclose(statsOut);
     }
 }
 
@@ -297,6 +1294,10 @@ static void getResponseFile(FILE *sockfile) {
  * to specify a filename to which the transmitted content is written. Option -d is used to specify
  * a directory in which a file of the same name as the requested file is created and filled with the
  * transmitted content. If none of these options is given, the transmitted content is written to stdout. 
+ * With option -2 all URLs are fetched concurrently over one HTTP/2 connection.
+ * Option -c gives a file with trusted certificates for https:// URLs, e.g. a self-signed server certificate.
+ * Option -t sets the connect timeout in milliseconds.
+ * Option --stats writes the timing statistics as JSON to stderr, --stats=FILE writes them to FILE.
  *@param argc The argument counter.
  * @param argv The argument vector.
  * @return Returns <code>EXIT_SUCCESS</code> on success, <code>EXIT_FAILURE</code> otherwise.
@@ -309,12 +1310,18 @@ int main(int argc, char *argv[]) {
     int opt_p = 0;
     int opt_o = 0;
     int opt_d = 0;
-    char *dir;
+    int opt_2 = 0;
+    int opt_c = 0;
+    char *dir = NULL;
 
     int opt;
+    static const struct option longOptions[] = {
+            {"stats", optional_argument, NULL, 'S'},
+            {NULL, 0, NULL, 0}
+    };
 
     // --------------------------------getOpt-------------------------------------
-    while ((opt = getopt(argc, argv, "p:o:d:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:o:d:c:t:2", longOptions, NULL)) != -1) {
         switch (opt) {
             case 'p': //option p is given
                 opt_p += 1;
@@ -328,15 +1335,37 @@ int main(int argc, char *argv[]) {
                 opt_d += 1;
                 dir = optarg;
                 break;
+            case '2': //option 2 is given
+                opt_2 = 1;
+                break;
+            case 't': //option t is given
+                connectTimeout = strtol(optarg, NULL, 10);
+                if (connectTimeout <= 0) {
+                    fprintf(stderr, "Error in %s: Connect timeout must be a positive number of milliseconds\n",
+                            program_name);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c': //option c is given
+                opt_c += 1;
+                caFile = optarg;
+                break;
+            case 'S': //option --stats is given
+                statsOut = optarg != NULL ? fopen(optarg, "w") : stderr;
+                if (statsOut == NULL) {
+                    fprintf(stderr, "Error in %s: Stats File not open\n", program_name);
+                    exit(EXIT_FAILURE);
+                }
+                break;
             default: /* '?' */ //somiting wrong ist given 
-                fprintf(stderr, "Usage: %s [-p PORT] [ -o FILE | -d DIR ] URL\n", program_name);
+                fprintf(stderr, "Usage: %s [-p PORT] [-2] [-c CAFILE] [-t TIMEOUT_MS] [--stats[=FILE]] [ -o FILE | -d DIR ] URL...\n", program_name);
                 return EXIT_FAILURE;
         }
     }
 
-    if (optind + 1 != argc) { //unspecified options or too many arguments
+    if (optind >= argc) { //no URL given
         fprintf(stderr,
-                "Error %s: unspecified options or too many arguments \nUsage: %s [-p PORT] [ -o FILE | -d DIR ] URL\n",
+                "Error %s: unspecified options or too many arguments \nUsage: %s [-p PORT] [-2] [-c CAFILE] [-t TIMEOUT_MS] [--stats[=FILE]] [ -o FILE | -d DIR ] URL...\n",
                 program_name, program_name);
         return EXIT_FAILURE;
     }
@@ -346,72 +1375,69 @@ int main(int argc, char *argv[]) {
 
     // ------------------------get Hostname and Filename----------------------------------
 
-    char *url = argv[optind];
-    fprintf(stderr, "Send Request for %s - ", url);
-    char *hostname;
-    char *filename;
-    int lastCharIsSlash = checkLastCharIsSlash(url);
-    char *http = "http://";
-
-    if (strncmp(url, http, strlen(http)) != 0) {
-        fprintf(stderr, "Error in %s: Invalid Url\n", program_name);
+    int count = argc - optind;
+    struct fetch *fetches = calloc(count, sizeof(struct fetch));
+    if (fetches == NULL) {
+        fprintf(stderr, "Error in %s: malloc failed\n", program_name);
         exit(EXIT_FAILURE);
     }
-
-    url += strlen(http);
-
-
-    int delimiterPos = -1;
-    for (int i = 0; i < strlen(url); ++i) {
-        if (url[i] == '/' ||
-            url[i] == ';' ||
-            url[i] == '?' ||
-            url[i] == ':' ||
-            url[i] == '@' ||
-            url[i] == '=' ||
-            url[i] == '&'
-                ) {
-            delimiterPos = i;
-            break;
-        }
+    if (statsOut != NULL) {
+        statFetches = fetches;
+        statCount = count;
+        atexit(writeStats);
     }
-
-    if (delimiterPos == -1) {
-        fprintf(stderr, "Error in %s: Invalid Url\n", program_name);
-        exit(EXIT_FAILURE);
+    for (int i = 0; i < count; ++i) {
+        parseUrl(argv[optind + i], &fetches[i]);
+        if (opt_2 && (strcmp(fetches[i].hostname, fetches[0].hostname) != 0 || fetches[i].https != fetches[0].https)) {
+            fprintf(stderr, "Error in %s: All URLs must have the same scheme and host with option -2\n", program_name);
+            exit(EXIT_FAILURE);
+        }
     }
 
-    filename = url;
-    filename += (delimiterPos + 1);
-    hostname = url;
-    hostname[delimiterPos] = '\0';
-
-
 //------------create Dir---------------
 
-    if (opt_d) {
-        if (checkDirExists(dir)) {
-            char *pathWithFilename = strdup(dir);
-            createDir(pathWithFilename, lastCharIsSlash, filename);
-            stdout = fopen(pathWithFilename, "w");
-        } else {
-            fprintf(stderr, "Error in %s: Directory does not exist\n", program_name);
-            exit(EXIT_FAILURE);
+    for (int i = 0; i < count; ++i) {
+        fetches[i].out = openOutput(&fetches[i], dir);
+        if (opt_2 && dir == NULL && count > 1) { // concurrent bodies are collected and written in order
+            fetches[i].out = tmpfile();
+            if (fetches[i].out == NULL) {
+                fprintf(stderr, "Error in %s: tmpfile failed\n", program_name);
+                exit(EXIT_FAILURE);
+            }
         }
     }
 
 //---------------------connect to server--------------
 
-    int sockfd = connectToServer(hostname, port);
-
-    FILE *sockfile = fdopen(sockfd, "r+");
-
-    sendRequestHeader(sockfile, hostname, filename);
-    readResponseHeader(sockfile);
-    getResponseFile(sockfile);
+    int success = 1;
+    if (opt_2) {
+        success = fetchHttp2(fetches, count, fetches[0].https && !opt_p ? "443" : port);
+    } else {
+        for (int i = 0; i < count; ++i) {
+            fprintf(stderr, "Send Request for %s://%s/%s - ", fetches[i].https ? "https" : "http", fetches[i].hostname,
+                    fetches[i].filename);
+            fetchHttp1(&fetches[i], fetches[i].https && !opt_p ? "443" : port);
+        }
+    }
 
-    close(sockfd);
+    for (int i = 0; i < count; ++i) {
+        if (fetches[i].out == stdout) {
+            continue;
+        }
+        if (opt_2 && dir == NULL && count > 1) {
+            uint8_t buffer[4096];
+            size_t n;
+            rewind(fetches[i].out);
+            while ((n = fread(buffer, 1, sizeof buffer, fetches[i].out)) > 0) {
+                fwrite(buffer, 1, n, stdout);
+            }
+        }
+        fclose(fetches[i].out);
+    }
     fclose(stdout);
-    return EXIT_SUCCESS;
+    if (statsOut == NULL) { // the statistics are written at exit and still need the URLs
+        free(fetches);
+    }
+    SSL_CTX_free(tlsContext);
+    return success ? EXIT_SUCCESS : 3;
 }
-
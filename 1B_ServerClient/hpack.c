@@ -0,0 +1,472 @@
+#include <string.h>
+
+#include "hpack.h"
+
+/**
+ * file hpack.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief HPACK header compression for HTTP/2 (RFC 7541).
+ *
+ * @details The Huffman code of RFC 7541 Appendix B is canonical, so it is completely described by the code
+ * length of every symbol. The decoding tables are built from these lengths on first use.
+ **/
+
+#define STATIC_TABLE_LEN 61
+#define HUFFMAN_SYMBOLS 257
+#define HUFFMAN_MAX_LEN 30
+#define ENTRY_OVERHEAD 32
+
+static const char *staticTable[STATIC_TABLE_LEN][2] = {
+        {":authority", ""},
+        {":method", "GET"},
+        {":method", "POST"},
+        {":path", "/"},
+        {":path", "/index.html"},
+        {":scheme", "http"},
+        {":scheme", "https"},
+        {":status", "200"},
+        {":status", "204"},
+        {":status", "206"},
+        {":status", "304"},
+        {":status", "400"},
+        {":status", "404"},
+        {":status", "500"},
+        {"accept-charset", ""},
+        {"accept-encoding", "gzip, deflate"},
+        {"accept-language", ""},
+        {"accept-ranges", ""},
+        {"accept", ""},
+        {"access-control-allow-origin", ""},
+        {"age", ""},
+        {"allow", ""},
+        {"authorization", ""},
+        {"cache-control", ""},
+        {"content-disposition", ""},
+        {"content-encoding", ""},
+        {"content-language", ""},
+        {"content-length", ""},
+        {"content-location", ""},
+        {"content-range", ""},
+        {"content-type", ""},
+        {"cookie", ""},
+        {"date", ""},
+        {"etag", ""},
+        {"expect", ""},
+        {"expires", ""},
+        {"from", ""},
+        {"host", ""},
+        {"if-match", ""},
+        {"if-modified-since", ""},
+        {"if-none-match", ""},
+        {"if-range", ""},
+        {"if-unmodified-since", ""},
+        {"last-modified", ""},
+        {"link", ""},
+        {"location", ""},
+        {"max-forwards", ""},
+        {"proxy-authenticate", ""},
+        {"proxy-authorization", ""},
+        {"range", ""},
+        {"referer", ""},
+        {"refresh", ""},
+        {"retry-after", ""},
+        {"server", ""},
+        {"set-cookie", ""},
+        {"strict-transport-security", ""},
+        {"transfer-encoding", ""},
+        {"user-agent", ""},
+        {"vary", ""},
+        {"via", ""},
+        {"www-authenticate", ""},
+};
+
+// code length of the symbols 0 to 255, the end of string symbol 256 has 30 bits
+static const unsigned char huffmanCodeLen[HUFFMAN_SYMBOLS - 1] = {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+        28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+        6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+        5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+        13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+        15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+        6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+        20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+        24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+        22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+        21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+        26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+        19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+        26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,};
+
+static int huffmanReady = 0;
+static unsigned int huffmanFirstCode[HUFFMAN_MAX_LEN + 1]; // first code of every length
+static unsigned int huffmanCount[HUFFMAN_MAX_LEN + 1]; // number of codes of every length
+static unsigned int huffmanOffset[HUFFMAN_MAX_LEN + 1]; // index of the first symbol of every length
+static unsigned short huffmanSymbols[HUFFMAN_SYMBOLS]; // symbols sorted by code
+
+/**
+* @brief build the canonical decoding tables from the code lengths
+**/
+static void initHuffman(void) {
+    unsigned int n = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_LEN; ++len) {
+        huffmanOffset[len] = n;
+        for (int symbol = 0; symbol < HUFFMAN_SYMBOLS; ++symbol) {
+            int symbolLen = symbol < HUFFMAN_SYMBOLS - 1 ? huffmanCodeLen[symbol] : HUFFMAN_MAX_LEN;
+            if (symbolLen == len) {
+                huffmanSymbols[n++] = symbol;
+            }
+        }
+        huffmanCount[len] = n - huffmanOffset[len];
+    }
+
+    unsigned int code = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_LEN; ++len) {
+        huffmanFirstCode[len] = code;
+        code = (code + huffmanCount[len]) << 1;
+    }
+    huffmanReady = 1;
+}
+
+/**
+* @brief decode a Huffman coded string
+* @param in: coded string
+* @param len: length of the coded string
+* @param out: buffer for the decoded string
+* @param outLen: set to the length of the decoded string
+* @return 0 on success and -1 on an invalid code or if the buffer is too small
+**/
+static int huffmanDecode(const unsigned char *in, size_t len, char *out, size_t *outLen) {
+    if (!huffmanReady) {
+        initHuffman();
+    }
+    unsigned int code = 0;
+    int codeLen = 0;
+    int paddingOnes = 1; // the bits of an unfinished code must be a prefix of the end of string symbol
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        for (int bit = 7; bit >= 0; --bit) {
+            unsigned int b = (in[i] >> bit) & 1;
+            code = (code << 1) | b;
+            codeLen++;
+            paddingOnes = paddingOnes && b;
+            if (code - huffmanFirstCode[codeLen] < huffmanCount[codeLen]) {
+                unsigned short symbol = huffmanSymbols[huffmanOffset[codeLen] + code - huffmanFirstCode[codeLen]];
+                if (symbol == HUFFMAN_SYMBOLS - 1 || n == HPACK_MAX_STRING) { // end of string must not be coded
+                    return -1;
+                }
+                out[n++] = (char) symbol;
+                code = 0;
+                codeLen = 0;
+                paddingOnes = 1;
+            } else if (codeLen == HUFFMAN_MAX_LEN) {
+                return -1;
+            }
+        }
+    }
+    if (codeLen > 7 || !paddingOnes) {
+        return -1;
+    }
+    *outLen = n;
+    return 0;
+}
+
+/**
+* @brief decode an integer with a prefix of some bits
+* @param pos: position in the block, moved behind the integer
+* @param end: end of the block
+* @param prefixBits: number of bits of the prefix
+* @param value: the decoded integer
+* @return 0 on success and -1 if the block ends or the integer is too large
+**/
+static int decodeInteger(const unsigned char **pos, const unsigned char *end, int prefixBits, size_t *value) {
+    if (*pos >= end) {
+        return -1;
+    }
+    size_t max = (1u << prefixBits) - 1;
+    *value = **pos & max;
+    (*pos)++;
+    if (*value < max) {
+        return 0;
+    }
+    int shift = 0;
+    for (;;) {
+        if (*pos >= end || shift > 21) {
+            return -1;
+        }
+        unsigned char b = **pos;
+        (*pos)++;
+        *value += (size_t) (b & 0x7f) << shift;
+        shift += 7;
+        if (!(b & 0x80)) {
+            return 0;
+        }
+    }
+}
+
+/**
+* @brief decode a string literal
+* @param pos: position in the block, moved behind the string
+* @param end: end of the block
+* @param out: buffer of HPACK_MAX_STRING bytes for the string
+* @param outLen: length of the string
+* @return 0 on success and -1 on an error
+**/
+static int decodeString(const unsigned char **pos, const unsigned char *end, char *out, size_t *outLen) {
+    if (*pos >= end) {
+        return -1;
+    }
+    int huffman = **pos & 0x80;
+    size_t len;
+    if (decodeInteger(pos, end, 7, &len) < 0 || len > (size_t) (end - *pos)) {
+        return -1;
+    }
+    const unsigned char *str = *pos;
+    *pos += len;
+    if (huffman) {
+        return huffmanDecode(str, len, out, outLen);
+    }
+    if (len > HPACK_MAX_STRING) {
+        return -1;
+    }
+    memcpy(out, str, len);
+    *outLen = len;
+    return 0;
+}
+
+/**
+* @brief remove the oldest entries until the table fits into a size
+* @param table: the table
+* @param size: size the table has to fit in
+**/
+static void evictEntries(struct hpack_table *table, size_t size) {
+    while (table->count > 0 && table->size > size) {
+        unsigned int last = table->count - 1;
+        table->size -= table->nameLen[last] + table->valueLen[last] + ENTRY_OVERHEAD;
+        table->dataLen = table->offset[last];
+        table->count--;
+    }
+}
+
+/**
+* @brief insert a new entry at the front of the dynamic table
+* @param table: the table
+* @param name: name of the entry
+* @param nameLen: length of the name
+* @param value: value of the entry
+* @param valueLen: length of the value
+**/
+static void insertEntry(struct hpack_table *table, const char *name, size_t nameLen,
+                        const char *value, size_t valueLen) {
+    size_t entrySize = nameLen + valueLen + ENTRY_OVERHEAD;
+    if (entrySize > table->maxSize) { // an entry larger than the table empties it
+        evictEntries(table, 0);
+        return;
+    }
+    evictEntries(table, table->maxSize - entrySize);
+
+    size_t len = nameLen + valueLen;
+    memmove(table->data + len, table->data, table->dataLen);
+    memcpy(table->data, name, nameLen);
+    memcpy(table->data + nameLen, value, valueLen);
+    table->dataLen += len;
+
+    memmove(table->offset + 1, table->offset, table->count * sizeof(table->offset[0]));
+    memmove(table->nameLen + 1, table->nameLen, table->count * sizeof(table->nameLen[0]));
+    memmove(table->valueLen + 1, table->valueLen, table->count * sizeof(table->valueLen[0]));
+    for (unsigned int i = 1; i <= table->count; ++i) {
+        table->offset[i] += len;
+    }
+    table->offset[0] = 0;
+    table->nameLen[0] = nameLen;
+    table->valueLen[0] = valueLen;
+    table->count++;
+    table->size += entrySize;
+}
+
+/**
+* @brief look up an entry of the static or dynamic table
+* @param table: the dynamic table
+* @param index: index of the entry, starting with 1
+* @param name: set to the name of the entry
+* @param nameLen: set to the length of the name
+* @param value: set to the value of the entry
+* @param valueLen: set to the length of the value
+* @return 0 on success and -1 if the index does not exist
+**/
+static int lookupEntry(const struct hpack_table *table, size_t index, const char **name, size_t *nameLen,
+                       const char **value, size_t *valueLen) {
+    if (index == 0) {
+        return -1;
+    }
+    if (index <= STATIC_TABLE_LEN) {
+        *name = staticTable[index - 1][0];
+        *nameLen = strlen(*name);
+        *value = staticTable[index - 1][1];
+        *valueLen = strlen(*value);
+        return 0;
+    }
+    index -= STATIC_TABLE_LEN + 1;
+    if (index >= table->count) {
+        return -1;
+    }
+    *name = table->data + table->offset[index];
+    *nameLen = table->nameLen[index];
+    *value = *name + *nameLen;
+    *valueLen = table->valueLen[index];
+    return 0;
+}
+
+void hpack_table_init(struct hpack_table *table) {
+    table->maxSize = HPACK_TABLE_SIZE;
+    table->size = 0;
+    table->count = 0;
+    table->dataLen = 0;
+}
+
+int hpack_decode(struct hpack_table *table, const unsigned char *block, size_t len,
+                 hpack_header_callback callback, void *context) {
+    const unsigned char *pos = block;
+    const unsigned char *end = block + len;
+    char nameBuffer[HPACK_MAX_STRING];
+    char valueBuffer[HPACK_MAX_STRING];
+
+    while (pos < end) {
+        unsigned char first = *pos;
+        size_t index;
+        const char *name;
+        const char *value;
+        size_t nameLen;
+        size_t valueLen;
+
+        if (first & 0x80) { // indexed header field
+            if (decodeInteger(&pos, end, 7, &index) < 0 ||
+                lookupEntry(table, index, &name, &nameLen, &value, &valueLen) < 0) {
+                return -1;
+            }
+            callback(context, name, nameLen, value, valueLen);
+            continue;
+        }
+
+        if ((first & 0xe0) == 0x20) { // dynamic table size update
+            if (decodeInteger(&pos, end, 5, &index) < 0 || index > HPACK_TABLE_SIZE) {
+                return -1;
+            }
+            table->maxSize = index;
+            evictEntries(table, index);
+            continue;
+        }
+
+        // literal with incremental indexing (6 bit prefix), without indexing or never indexed (4 bit prefix)
+        int indexing = (first & 0xc0) == 0x40;
+        if (decodeInteger(&pos, end, indexing ? 6 : 4, &index) < 0) {
+            return -1;
+        }
+        if (index > 0) {
+            const char *unused;
+            size_t unusedLen;
+            if (lookupEntry(table, index, &name, &nameLen, &unused, &unusedLen) < 0) {
+                return -1;
+            }
+            // the name may live in the dynamic table which is changed by the insert below
+            memcpy(nameBuffer, name, nameLen);
+        } else if (decodeString(&pos, end, nameBuffer, &nameLen) < 0) {
+            return -1;
+        }
+        if (decodeString(&pos, end, valueBuffer, &valueLen) < 0) {
+            return -1;
+        }
+        if (indexing) {
+            insertEntry(table, nameBuffer, nameLen, valueBuffer, valueLen);
+        }
+        callback(context, nameBuffer, nameLen, valueBuffer, valueLen);
+    }
+    return 0;
+}
+
+/**
+* @brief encode an integer with a prefix of some bits
+* @param out: buffer for the integer
+* @param cap: size of the buffer
+* @param prefixBits: number of bits of the prefix
+* @param flags: bits above the prefix in the first byte
+* @param value: the integer
+* @return the number of written bytes or 0 if the buffer is too small
+**/
+static size_t encodeInteger(unsigned char *out, size_t cap, int prefixBits, unsigned char flags, size_t value) {
+    size_t max = (1u << prefixBits) - 1;
+    size_t n = 0;
+    if (cap == 0) {
+        return 0;
+    }
+    if (value < max) {
+        out[n++] = flags | value;
+        return n;
+    }
+    out[n++] = flags | max;
+    value -= max;
+    while (value >= 0x80) {
+        if (n == cap) {
+            return 0;
+        }
+        out[n++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    if (n == cap) {
+        return 0;
+    }
+    out[n++] = value;
+    return n;
+}
+
+/**
+* @brief encode a string literal without Huffman coding
+* @param out: buffer for the string
+* @param cap: size of the buffer
+* @param str: the string
+* @return the number of written bytes or 0 if the buffer is too small
+**/
+static size_t encodeString(unsigned char *out, size_t cap, const char *str) {
+    size_t len = strlen(str);
+    size_t n = encodeInteger(out, cap, 7, 0, len);
+    if (n == 0 || cap - n < len) {
+        return 0;
+    }
+    memcpy(out + n, str, len);
+    return n + len;
+}
+
+size_t hpack_encode(unsigned char *out, size_t cap, const char *name, const char *value) {
+    size_t nameIndex = 0;
+    for (size_t i = 0; i < STATIC_TABLE_LEN; ++i) {
+        if (strcmp(staticTable[i][0], name) == 0) {
+            if (strcmp(staticTable[i][1], value) == 0) {
+                return encodeInteger(out, cap, 7, 0x80, i + 1);
+            }
+            if (nameIndex == 0) {
+                nameIndex = i + 1;
+            }
+        }
+    }
+
+    // literal header field without indexing
+    size_t n = encodeInteger(out, cap, 4, 0x00, nameIndex);
+    if (n == 0) {
+        return 0;
+    }
+    if (nameIndex == 0) {
+        size_t nameLen = encodeString(out + n, cap - n, name);
+        if (nameLen == 0) {
+            return 0;
+        }
+        n += nameLen;
+    }
+    size_t valueLen = encodeString(out + n, cap - n, value);
+    if (valueLen == 0) {
+        return 0;
+    }
+    return n + valueLen;
+}
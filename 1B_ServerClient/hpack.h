@@ -0,0 +1,67 @@
+/**
+ * file hpack.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief HPACK header compression for HTTP/2 (RFC 7541).
+ *
+ * @details The decoder supports the whole format including the dynamic table and Huffman coded strings.
+ * The encoder only emits indexed fields for exact matches in the static table and literals without
+ * indexing otherwise, so it never has to keep a dynamic table in sync with the peer.
+ **/
+
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <stddef.h>
+
+#define HPACK_TABLE_SIZE 4096
+#define HPACK_MAX_ENTRIES (HPACK_TABLE_SIZE / 32)
+#define HPACK_MAX_STRING 4096
+
+/**
+ * dynamic table of a decoder, entry 0 is the newest entry
+ **/
+struct hpack_table {
+    size_t maxSize; // size limit set by the encoder, at most HPACK_TABLE_SIZE
+    size_t size; // size of all entries as defined in RFC 7541 section 4.1
+    unsigned int count;
+    unsigned short offset[HPACK_MAX_ENTRIES];
+    unsigned short nameLen[HPACK_MAX_ENTRIES];
+    unsigned short valueLen[HPACK_MAX_ENTRIES];
+    size_t dataLen;
+    char data[HPACK_TABLE_SIZE]; // names and values of all entries, newest first
+};
+
+typedef void (*hpack_header_callback)(void *context, const char *name, size_t nameLen,
+                                      const char *value, size_t valueLen);
+
+/**
+* @brief initialize an empty dynamic table
+* @param table: the table
+**/
+void hpack_table_init(struct hpack_table *table);
+
+/**
+* @brief decode a complete header block
+* @details the block has to be decoded even if the request is refused, otherwise the dynamic table is out of sync
+* @param table: dynamic table of the connection
+* @param block: the header block
+* @param len: length of the header block
+* @param callback: called for every decoded header field
+* @param context: passed to the callback
+* @return 0 on success and -1 on a compression error
+**/
+int hpack_decode(struct hpack_table *table, const unsigned char *block, size_t len,
+                 hpack_header_callback callback, void *context);
+
+/**
+* @brief encode a header field
+* @param out: buffer for the encoded field
+* @param cap: size of the buffer
+* @param name: lower case name of the header field
+* @param value: value of the header field
+* @return the number of written bytes or 0 if the buffer is too small
+**/
+size_t hpack_encode(unsigned char *out, size_t cap, const char *name, const char *value);
+
+#endif
@@ -0,0 +1,146 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http1.h"
+
+/**
+ * file http1.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief HTTP/1.1 requests and responses over a buffered OpenSSL BIO.
+ *
+ * @details Lines are read with BIO_gets, so the BIO has to be buffered (BIO_f_buffer or SSL).
+ **/
+
+int http1_send_request(BIO *bio, const char *host, const char *target) {
+    if (BIO_printf(bio, "GET /%s HTTP/1.1\r\nHost: "
+                        "%s\r\n"
+                        "Connection: close\r\n\r\n", target, host) <= 0) {
+        return -1;
+    }
+    return BIO_flush(bio) == 1 ? 0 : -1; // send all buffered data
+}
+
+int http1_read_status_line(BIO *bio, struct http1_response *response) {
+    char line[HTTP1_LINE_LEN];
+    if (BIO_gets(bio, line, sizeof line) <= 0) {
+        return -1;
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+    if (strncmp(line, "HTTP/1.1 ", 9) != 0) {
+        return -1;
+    }
+    char *status = line + 9;
+    if (strspn(status, "0123456789") != 3 || (status[3] != ' ' && status[3] != '\0')) {
+        return -1;
+    }
+    response->status = strtol(status, NULL, 10);
+    strcpy(response->reason, status[3] == ' ' ? status + 4 : "");
+    response->bodyLen = HTTP1_BODY_UNTIL_CLOSE;
+    return 0;
+}
+
+/**
+* @brief parses the value of a Content-Length header field
+* @param value: the value after the colon, with the line break
+* @return the length or -1 if the value is no decimal number without sign
+**/
+static long long parseContentLength(const char *value) {
+    value += strspn(value, " \t");
+    size_t digits = strspn(value, "0123456789");
+    if (digits == 0 || value[digits + strspn(value + digits, " \t\r\n")] != '\0') {
+        return -1;
+    }
+    errno = 0;
+    long long len = strtoll(value, NULL, 10);
+    return errno == ERANGE ? -1 : len;
+}
+
+int http1_read_header_fields(BIO *bio, struct http1_response *response) {
+    char line[HTTP1_LINE_LEN];
+    int valid = 1;
+    response->bodyLen = HTTP1_BODY_UNTIL_CLOSE;
+    while (BIO_gets(bio, line, sizeof line) > 0 && strcmp(line, "\r\n") != 0 && strcmp(line, "\n") != 0) {
+        if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            // chunked is always the last coding, nothing else is requested
+            char *last = strrchr(line, ',');
+            last = last != NULL ? last + 1 : line + 18;
+            last += strspn(last, " \t");
+            if (strncasecmp(last, "chunked", 7) == 0) {
+                response->bodyLen = HTTP1_BODY_CHUNKED;
+            }
+        } else if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            long long len = parseContentLength(line + 15);
+            valid = valid && len >= 0;
+            if (response->bodyLen != HTTP1_BODY_CHUNKED) {
+                response->bodyLen = len;
+            }
+        }
+    }
+    return valid ? 0 : -1;
+}
+
+/**
+* @brief passes bytes of the body to the callback
+* @param bio: buffered connection to the server
+* @param len: number of bytes or HTTP1_BODY_UNTIL_CLOSE to read until the server closes the connection
+* @param buffer: buffer for the pieces
+* @param bufferLen: size of the buffer
+* @param callback: called for every piece
+* @param context: passed to the callback
+* @return 1 on success, 0 if the connection was closed too early or failed and -1 if the callback stopped
+**/
+static int copyBody(BIO *bio, long long len, void *buffer, size_t bufferLen, http1_body_callback callback,
+                    void *context) {
+    size_t max = bufferLen > 0x40000000 ? 0x40000000 : bufferLen; // BIO_read takes an int
+    while (len != 0) {
+        int want = len < 0 || (unsigned long long) len > max ? (int) max : (int) len;
+        int n = BIO_read(bio, buffer, want);
+        if (n <= 0) {
+            // with TLS a missing close_notify also ends the body, a failed read of a socket does not
+            return len < 0 && n == 0;
+        }
+        if (callback(context, buffer, n) < 0) {
+            return -1;
+        }
+        if (len > 0) {
+            len -= n;
+        }
+    }
+    return 1;
+}
+
+int http1_read_body(BIO *bio, long long bodyLen, void *buffer, size_t bufferLen, http1_body_callback callback,
+                    void *context) {
+    if (bodyLen != HTTP1_BODY_CHUNKED) {
+        return copyBody(bio, bodyLen, buffer, bufferLen, callback, context);
+    }
+    for (;;) {
+        char line[HTTP1_LINE_LEN];
+        char *end;
+        if (BIO_gets(bio, line, sizeof line) <= 0) {
+            return 0;
+        }
+        // chunk extensions after ';' are ignored
+        long long chunkLen = strtoll(line, &end, 16);
+        if (end == line || chunkLen < 0 || (*end != ';' && *end != '\r' && *end != '\n' && *end != ' ')) {
+            return -1;
+        }
+        if (chunkLen == 0) {
+            // skip the trailer fields up to the empty line
+            int n;
+            while ((n = BIO_gets(bio, line, sizeof line)) > 0 && strcmp(line, "\r\n") != 0 && strcmp(line, "\n") != 0) {
+            }
+            return n > 0;
+        }
+        int copied = copyBody(bio, chunkLen, buffer, bufferLen, callback, context);
+        if (copied <= 0) {
+            return copied;
+        }
+        if (BIO_gets(bio, line, sizeof line) <= 0) {
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * file http1.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief HTTP/1.1 requests and responses over a buffered OpenSSL BIO.
+ *
+ * @details Used by the client and by the upstream fetches of the server in proxy mode. The functions block
+ * until the BIO delivered what they need and report errors with their return value, the callers decide if
+ * an error ends the program. A body is either Content-Length bytes, chunked or runs until the connection is
+ * closed, chunked bodies are decoded while they arrive and are never buffered as a whole.
+ **/
+
+#ifndef HTTP1_H
+#define HTTP1_H
+
+#include <stddef.h>
+
+#include <openssl/bio.h>
+
+#define HTTP1_LINE_LEN 2048
+#define HTTP1_BODY_UNTIL_CLOSE -1 // the response has neither a Content-Length nor chunked encoding
+#define HTTP1_BODY_CHUNKED -2
+
+struct http1_response {
+    long status;
+    char reason[HTTP1_LINE_LEN]; // reason phrase of the status line without the line break
+    long long bodyLen; // Content-Length, HTTP1_BODY_CHUNKED or HTTP1_BODY_UNTIL_CLOSE
+};
+
+/**
+* @brief called for every piece of a body
+* @param context: the context which was passed to http1_read_body
+* @param data: the bytes
+* @param len: number of bytes
+* @return 0 to continue and -1 to stop reading
+**/
+typedef int (*http1_body_callback)(void *context, const void *data, size_t len);
+
+/**
+* @brief send a GET request header
+* @details the request asks the server to close the connection after the response
+* @param bio: buffered connection to the server
+* @param host: value of the Host header
+* @param target: requested path without the leading slash, percent-encoded
+* @return 0 on success and -1 if the request could not be sent
+**/
+int http1_send_request(BIO *bio, const char *host, const char *target);
+
+/**
+* @brief read the status line of a response
+* @param bio: buffered connection to the server
+* @param response: status and reason are set
+* @return 0 on success and -1 if the connection was closed or the line is no HTTP/1.1 status line
+**/
+int http1_read_status_line(BIO *bio, struct http1_response *response);
+
+/**
+* @brief read the header fields of a response up to the empty line
+* @details Transfer-Encoding chunked wins over a Content-Length
+* @param bio: buffered connection to the server
+* @param response: bodyLen is set
+* @return 0 on success and -1 if a Content-Length is no decimal number
+**/
+int http1_read_header_fields(BIO *bio, struct http1_response *response);
+
+/**
+* @brief read the body of a response
+* @param bio: buffered connection to the server
+* @param bodyLen: bodyLen of the response
+* @param buffer: buffer for the pieces of the body
+* @param bufferLen: size of the buffer
+* @param callback: called for every piece
+* @param context: passed to the callback
+* @return 1 if the whole body was read, 0 if the connection was closed too early or failed and -1 if a chunk
+* size is invalid or the callback stopped. A body until the close is whole if the connection was closed, not
+* if reading failed.
+**/
+int http1_read_body(BIO *bio, long long bodyLen, void *buffer, size_t bufferLen, http1_body_callback callback,
+                    void *context);
+
+#endif
@@ -0,0 +1,94 @@
+#include <string.h>
+
+#include "http2.h"
+
+/**
+ * file http2.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief HTTP/2 framing (RFC 7540) which is shared by the server and the client.
+ **/
+
+uint32_t http2_get32(const unsigned char *in) {
+    return ((uint32_t) in[0] << 24) | ((uint32_t) in[1] << 16) | ((uint32_t) in[2] << 8) | in[3];
+}
+
+void http2_put32(unsigned char *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+void http2_read_frame_header(const unsigned char *in, struct http2_frame *frame) {
+    frame->length = ((uint32_t) in[0] << 16) | ((uint32_t) in[1] << 8) | in[2];
+    frame->type = in[3];
+    frame->flags = in[4];
+    frame->streamId = http2_get32(in + 5) & 0x7fffffff;
+}
+
+void http2_write_frame_header(unsigned char *out, uint32_t length, uint8_t type, uint8_t flags, uint32_t streamId) {
+    out[0] = length >> 16;
+    out[1] = length >> 8;
+    out[2] = length;
+    out[3] = type;
+    out[4] = flags;
+    http2_put32(out + 5, streamId & 0x7fffffff);
+}
+
+size_t http2_write_setting(unsigned char *out, uint16_t id, uint32_t value) {
+    out[0] = id >> 8;
+    out[1] = id;
+    http2_put32(out + 2, value);
+    return 6;
+}
+
+int http2_strip_padding(const struct http2_frame *frame, const unsigned char **payload, size_t *len) {
+    size_t padding = 0;
+    *len = frame->length;
+    if (frame->flags & HTTP2_FLAG_PADDED) {
+        if (*len < 1) {
+            return -1;
+        }
+        padding = **payload;
+        (*payload)++;
+        (*len)--;
+    }
+    if (frame->type == HTTP2_HEADERS && (frame->flags & HTTP2_FLAG_PRIORITY)) {
+        if (*len < 5) {
+            return -1;
+        }
+        *payload += 5; // stream dependency and weight
+        *len -= 5;
+    }
+    if (padding > *len) {
+        return -1;
+    }
+    *len -= padding;
+    return 0;
+}
+
+int http2_base64url_decode(const char *in, unsigned char *out, size_t cap, size_t *len) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    uint32_t bits = 0;
+    int bitCount = 0;
+    size_t n = 0;
+
+    for (; *in != '\0' && *in != '='; ++in) {
+        const char *pos = strchr(alphabet, *in);
+        if (pos == NULL) {
+            return -1;
+        }
+        bits = (bits << 6) | (uint32_t) (pos - alphabet);
+        bitCount += 6;
+        if (bitCount >= 8) {
+            if (n == cap) {
+                return -1;
+            }
+            bitCount -= 8;
+            out[n++] = (bits >> bitCount) & 0xff;
+        }
+    }
+    *len = n;
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * file http2.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief HTTP/2 framing (RFC 7540) which is shared by the server and the client.
+ **/
+
+#ifndef HTTP2_H
+#define HTTP2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define HTTP2_PREFACE_LEN 24
+#define HTTP2_FRAME_HEADER_LEN 9
+#define HTTP2_DEFAULT_FRAME_SIZE 16384
+#define HTTP2_DEFAULT_WINDOW 65535
+#define HTTP2_MAX_WINDOW 0x7fffffffL
+
+#define HTTP2_DATA 0x0
+#define HTTP2_HEADERS 0x1
+#define HTTP2_PRIORITY 0x2
+#define HTTP2_RST_STREAM 0x3
+#define HTTP2_SETTINGS 0x4
+#define HTTP2_PUSH_PROMISE 0x5
+#define HTTP2_PING 0x6
+#define HTTP2_GOAWAY 0x7
+#define HTTP2_WINDOW_UPDATE 0x8
+#define HTTP2_CONTINUATION 0x9
+
+#define HTTP2_FLAG_END_STREAM 0x1
+#define HTTP2_FLAG_ACK 0x1
+#define HTTP2_FLAG_END_HEADERS 0x4
+#define HTTP2_FLAG_PADDED 0x8
+#define HTTP2_FLAG_PRIORITY 0x20
+
+#define HTTP2_SETTINGS_HEADER_TABLE_SIZE 0x1
+#define HTTP2_SETTINGS_ENABLE_PUSH 0x2
+#define HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS 0x3
+#define HTTP2_SETTINGS_INITIAL_WINDOW_SIZE 0x4
+#define HTTP2_SETTINGS_MAX_FRAME_SIZE 0x5
+#define HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE 0x6
+
+#define HTTP2_NO_ERROR 0x0
+#define HTTP2_PROTOCOL_ERROR 0x1
+#define HTTP2_INTERNAL_ERROR 0x2
+#define HTTP2_FLOW_CONTROL_ERROR 0x3
+#define HTTP2_FRAME_SIZE_ERROR 0x6
+#define HTTP2_REFUSED_STREAM 0x7
+#define HTTP2_CANCEL 0x8
+#define HTTP2_COMPRESSION_ERROR 0x9
+
+struct http2_frame {
+    uint32_t length;
+    uint8_t type;
+    uint8_t flags;
+    uint32_t streamId;
+};
+
+/**
+* @brief read a 32 bit number in network byte order
+* @param in: the bytes
+* @return the number
+**/
+uint32_t http2_get32(const unsigned char *in);
+
+/**
+* @brief write a 32 bit number in network byte order
+* @param out: buffer for 4 bytes
+* @param value: the number
+**/
+void http2_put32(unsigned char *out, uint32_t value);
+
+/**
+* @brief parse a frame header
+* @param in: HTTP2_FRAME_HEADER_LEN bytes
+* @param frame: the parsed header
+**/
+void http2_read_frame_header(const unsigned char *in, struct http2_frame *frame);
+
+/**
+* @brief write a frame header
+* @param out: buffer for HTTP2_FRAME_HEADER_LEN bytes
+* @param length: length of the payload
+* @param type: type of the frame
+* @param flags: flags of the frame
+* @param streamId: stream of the frame or 0 for the connection
+**/
+void http2_write_frame_header(unsigned char *out, uint32_t length, uint8_t type, uint8_t flags, uint32_t streamId);
+
+/**
+* @brief write one setting of a SETTINGS frame
+* @param out: buffer for 6 bytes
+* @param id: identifier of the setting
+* @param value: value of the setting
+* @return the number of written bytes
+**/
+size_t http2_write_setting(unsigned char *out, uint16_t id, uint32_t value);
+
+/**
+* @brief remove padding and priority fields from the payload of a DATA or HEADERS frame
+* @param frame: the frame
+* @param payload: set to the start of the data, moved behind the pad length and priority fields
+* @param len: set to the length of the data without padding
+* @return 0 on success and -1 if the padding is longer than the frame
+**/
+int http2_strip_padding(const struct http2_frame *frame, const unsigned char **payload, size_t *len);
+
+/**
+* @brief decode base64url without padding as used by the HTTP2-Settings header
+* @param in: the encoded string
+* @param out: buffer for the decoded bytes
+* @param cap: size of the buffer
+* @param len: set to the number of decoded bytes
+* @return 0 on success and -1 on an invalid character or if the buffer is too small
+**/
+int http2_base64url_decode(const char *in, unsigned char *out, size_t cap, size_t *len);
+
+#endif
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "bundle.h"
+
+/**
+ * file mkbundle.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Packs a document root into one bundle file which the server maps with option -b.
+ *
+ * @details Usage: mkbundle [-i INDEX] DOC_ROOT BUNDLE
+ * All regular files and directories below DOC_ROOT are packed, symbolic links and special files are
+ * skipped. Option -i is the index filename of the directories like at the server, the default is
+ * index.html. The bundle is written to BUNDLE.tmp and renamed to BUNDLE when it is complete, so a server
+ * which is reloaded afterwards never maps a half written bundle.
+ **/
+
+#define COPY_BUFFER_LEN (1024 * 1024)
+
+static char *program_name;
+
+/**
+ * a file or directory which is packed
+ **/
+struct item {
+    char *path; // relative to the document root, "" for the document root
+    int isDir;
+    uint64_t size;
+    int64_t modified;
+    long content; // item whose contents are stored, the index file of a directory or -1
+    uint64_t offset;
+    uint64_t pathOffset;
+};
+
+static struct item *items;
+static size_t itemCount;
+static size_t itemCap;
+
+/**
+* @brief prints an error and exits
+* @param what: what failed
+* @param path: the file or NULL
+**/
+static void fail(const char *what, const char *path) {
+    if (path != NULL) {
+        fprintf(stderr, "Error in %s: %s %s: %s\n", program_name, what, path, strerror(errno));
+    } else {
+        fprintf(stderr, "Error in %s: %s\n", program_name, what);
+    }
+    exit(EXIT_FAILURE);
+}
+
+/**
+* @brief adds a file or directory to the list of items
+* @param path: relative path, the item takes it over
+* @param st: status of the file
+**/
+static void addItem(char *path, const struct stat *st) {
+    if (itemCount == itemCap) {
+        itemCap = itemCap == 0 ? 1024 : itemCap * 2;
+        items = realloc(items, itemCap * sizeof *items);
+        if (items == NULL) {
+            fail("Out of memory", NULL);
+        }
+    }
+    struct item *item = &items[itemCount++];
+    item->path = path;
+    item->isDir = S_ISDIR(st->st_mode);
+    item->size = item->isDir ? 0 : (uint64_t) st->st_size;
+    item->modified = st->st_mtime;
+}
+
+/**
+* @brief joins a directory and a name
+* @param dir: relative directory, "" for the document root
+* @param name: name in the directory
+* @return the new path
+**/
+static char *joinPath(const char *dir, const char *name) {
+    char *path = malloc(strlen(dir) + strlen(name) + 2);
+    if (path == NULL) {
+        fail("Out of memory", NULL);
+    }
+    sprintf(path, "%s%s%s", dir, dir[0] != '\0' ? "/" : "", name);
+    return path;
+}
+
+/**
+* @brief adds all files and directories below a directory
+* @param root: the document root
+* @param dir: relative path of the directory
+**/
+static void walkDirectory(const char *root, const char *dir) {
+    char *dirPath = joinPath(root, dir);
+    DIR *stream = opendir(dirPath);
+    if (stream == NULL) {
+        fail("Cannot open directory", dirPath);
+    }
+    struct dirent *entry;
+    while ((entry = readdir(stream)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        char *path = joinPath(dir, entry->d_name);
+        char *fullPath = joinPath(root, path);
+        struct stat st;
+        if (lstat(fullPath, &st) < 0) {
+            fail("Cannot stat", fullPath);
+        }
+        free(fullPath);
+        if (S_ISREG(st.st_mode) || S_ISDIR(st.st_mode)) {
+            addItem(path, &st);
+            if (S_ISDIR(st.st_mode)) {
+                walkDirectory(root, path);
+            }
+        } else {
+            free(path);
+        }
+    }
+    closedir(stream);
+    free(dirPath);
+}
+
+/**
+* @brief compares two items by path, for qsort and bsearch
+**/
+static int compareItems(const void *a, const void *b) {
+    return strcmp(((const struct item *) a)->path, ((const struct item *) b)->path);
+}
+
+/**
+* @brief writes zero bytes up to an offset
+* @param out: the bundle
+* @param position: current offset in the bundle, set to offset
+* @param offset: the new offset
+**/
+static void pad(FILE *out, uint64_t *position, uint64_t offset) {
+    while (*position < offset) {
+        putc(0, out);
+        ++*position;
+    }
+}
+
+/**
+* @brief copies the contents of a file into the bundle
+* @details exactly size bytes are written, a file which shrank since the walk is filled up with zero bytes
+* @param out: the bundle
+* @param root: the document root
+* @param item: the file
+**/
+static void copyContents(FILE *out, const char *root, const struct item *item) {
+    static char buffer[COPY_BUFFER_LEN];
+    char *fullPath = joinPath(root, item->path);
+    FILE *in = fopen(fullPath, "rb");
+    if (in == NULL) {
+        fail("Cannot open", fullPath);
+    }
+    uint64_t left = item->size;
+    while (left > 0) {
+        size_t n = fread(buffer, 1, left < COPY_BUFFER_LEN ? left : COPY_BUFFER_LEN, in);
+        if (n == 0) {
+            if (ferror(in)) {
+                fail("Cannot read", fullPath);
+            }
+            memset(buffer, 0, sizeof buffer);
+            n = left < COPY_BUFFER_LEN ? left : COPY_BUFFER_LEN;
+        }
+        fwrite(buffer, 1, n, out);
+        left -= n;
+    }
+    fclose(in);
+    free(fullPath);
+}
+
+/**
+* @brief writes the bundle
+* @param root: the document root
+* @param bundlePath: the bundle file
+**/
+static void writeBundle(const char *root, const char *bundlePath) {
+    struct bundle_header header;
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, BUNDLE_MAGIC, sizeof header.magic);
+    header.version = BUNDLE_VERSION;
+    header.entryCount = itemCount;
+    header.slotCount = 1;
+    while (header.slotCount < 2 * itemCount) {
+        header.slotCount *= 2;
+    }
+
+    // layout: header, slots, paths, contents
+    header.pathsOffset = sizeof header + (uint64_t) header.slotCount * sizeof(struct bundle_entry);
+    for (size_t i = 0; i < itemCount; ++i) {
+        items[i].pathOffset = header.pathsLen;
+        header.pathsLen += strlen(items[i].path);
+    }
+    uint64_t position = header.pathsOffset + header.pathsLen;
+    header.dataOffset = (position + BUNDLE_PAGE_SIZE - 1) / BUNDLE_PAGE_SIZE * BUNDLE_PAGE_SIZE;
+    position = header.dataOffset;
+    for (size_t i = 0; i < itemCount; ++i) {
+        if (items[i].isDir) {
+            continue;
+        }
+        // a page aligned file can be sent with sendfile without touching a neighbour's pages
+        if (items[i].size >= BUNDLE_PAGE_SIZE) {
+            position = (position + BUNDLE_PAGE_SIZE - 1) / BUNDLE_PAGE_SIZE * BUNDLE_PAGE_SIZE;
+        }
+        items[i].offset = position;
+        position += items[i].size;
+    }
+    header.size = position;
+
+    struct bundle_entry *slots = calloc(header.slotCount, sizeof *slots);
+    if (slots == NULL) {
+        fail("Out of memory", NULL);
+    }
+    for (size_t i = 0; i < itemCount; ++i) {
+        const struct item *item = &items[i];
+        const struct item *content = item->content >= 0 ? &items[item->content] : NULL;
+        size_t pathLen = strlen(item->path);
+        uint64_t hash = bundle_hash(item->path, pathLen);
+        uint32_t slot = hash & (header.slotCount - 1);
+        while (slots[slot].flags != 0) {
+            slot = (slot + 1) & (header.slotCount - 1);
+        }
+        slots[slot].hash = hash;
+        slots[slot].offset = content != NULL ? content->offset : 0;
+        slots[slot].size = content != NULL ? content->size : 0;
+        slots[slot].modified = content != NULL ? content->modified : item->modified;
+        slots[slot].pathOffset = item->pathOffset;
+        slots[slot].pathLen = pathLen;
+        slots[slot].flags = BUNDLE_ENTRY_USED;
+        if (item->isDir) {
+            slots[slot].flags |= content != NULL ? BUNDLE_ENTRY_DIRECTORY : BUNDLE_ENTRY_NO_INDEX;
+        }
+    }
+
+    char *tmpPath = malloc(strlen(bundlePath) + 5);
+    if (tmpPath == NULL) {
+        fail("Out of memory", NULL);
+    }
+    sprintf(tmpPath, "%s.tmp", bundlePath);
+    FILE *out = fopen(tmpPath, "wb");
+    if (out == NULL) {
+        fail("Cannot create", tmpPath);
+    }
+    fwrite(&header, sizeof header, 1, out);
+    fwrite(slots, sizeof *slots, header.slotCount, out);
+    for (size_t i = 0; i < itemCount; ++i) {
+        fputs(items[i].path, out);
+    }
+    position = header.pathsOffset + header.pathsLen;
+    for (size_t i = 0; i < itemCount; ++i) {
+        if (!items[i].isDir) {
+            pad(out, &position, items[i].offset);
+            copyContents(out, root, &items[i]);
+            position += items[i].size;
+        }
+    }
+    pad(out, &position, header.size);
+    if (fflush(out) != 0 || ferror(out) || fsync(fileno(out)) < 0 || fclose(out) != 0) {
+        fail("Cannot write", tmpPath);
+    }
+    if (rename(tmpPath, bundlePath) < 0) {
+        fail("Cannot rename", tmpPath);
+    }
+    fprintf(stderr, "Packed %zu files and directories into %s (%llu bytes, %u slots)\n", itemCount,
+            bundlePath, (unsigned long long) header.size, (unsigned) header.slotCount);
+    free(tmpPath);
+    free(slots);
+}
+
+/**
+ * Program entry point.
+ * @brief The program packs a document root into a bundle.
+ * @details The items are sorted by path, so a directory is resolved to its index file with bsearch.
+ * @param argc The argument counter.
+ * @param argv The argument vector.
+ * @return Returns EXIT_SUCCESS.
+ **/
+int main(int argc, char **argv) {
+    program_name = argv[0];
+    char *indexFile = "index.html";
+    int c;
+    int i = 0;
+    while ((c = getopt(argc, argv, "i:")) != -1) {
+        switch (c) {
+            case 'i':
+                indexFile = optarg;
+                i++;
+                break;
+            case '?':
+            default:
+                fprintf(stderr, "Usage: %s [-i INDEX] DOC_ROOT BUNDLE\n", program_name);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (i > 1 || argc - optind != 2 || strchr(indexFile, '/') != NULL) {
+        fprintf(stderr, "Usage: %s [-i INDEX] DOC_ROOT BUNDLE\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    char *root = argv[optind];
+
+    struct stat st;
+    if (stat(root, &st) < 0 || !S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "Error in %s: %s is no directory\n", program_name, root);
+        exit(EXIT_FAILURE);
+    }
+    char *rootPath = joinPath("", "");
+    addItem(rootPath, &st);
+    walkDirectory(root, "");
+    qsort(items, itemCount, sizeof *items, compareItems);
+
+    for (size_t n = 0; n < itemCount; ++n) {
+        items[n].content = items[n].isDir ? -1 : (long) n;
+    }
+    for (size_t n = 0; n < itemCount; ++n) {
+        if (items[n].isDir) {
+            struct item key;
+            key.path = joinPath(items[n].path, indexFile);
+            struct item *index = bsearch(&key, items, itemCount, sizeof *items, compareItems);
+            if (index != NULL && !index->isDir) {
+                items[n].content = index - items;
+            }
+            free(key.path);
+        }
+    }
+
+    writeBundle(root, argv[optind + 1]);
+    for (size_t n = 0; n < itemCount; ++n) {
+        free(items[n].path);
+    }
+    free(items);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+
+#include "pool.h"
+
+/**
+ * file pool.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Slab pools for fixed size objects and size-classed buffers.
+ *
+ * @details A slab is one malloc for POOL_SLAB_OBJECTS objects which are all put on the free list at once.
+ **/
+
+static const size_t bufferClassSizes[BUFFER_CLASSES] = {512, 2048, 16384};
+static const char *bufferClassNames[BUFFER_CLASSES] = {"buffer 512", "buffer 2048", "buffer 16384"};
+
+void pool_init(struct pool *pool, const char *name, size_t objectSize) {
+    // every object has to hold the free list link and keep the alignment of the next object
+    size_t align = sizeof(long double) > sizeof(void *) ? sizeof(long double) : sizeof(void *);
+    if (objectSize < sizeof(struct pool_object)) {
+        objectSize = sizeof(struct pool_object);
+    }
+    pool->objectSize = (objectSize + align - 1) / align * align;
+    pool->name = name;
+    pool->freeList = NULL;
+    pool->hits = 0;
+    pool->misses = 0;
+    pool->inUse = 0;
+    pool->slabs = 0;
+}
+
+/**
+* @brief allocate a new slab and put its objects on the free list
+* @param pool: the pool
+* @return 1 on success and 0 if no memory is left
+**/
+static int growPool(struct pool *pool) {
+    char *slab = malloc(pool->objectSize * POOL_SLAB_OBJECTS);
+    if (slab == NULL) {
+        return 0;
+    }
+    for (int i = POOL_SLAB_OBJECTS - 1; i >= 0; --i) {
+        struct pool_object *object = (struct pool_object *) (slab + i * pool->objectSize);
+        object->next = pool->freeList;
+        pool->freeList = object;
+    }
+    pool->slabs++;
+    return 1;
+}
+
+void *pool_get(struct pool *pool) {
+    if (pool->freeList != NULL) {
+        pool->hits++;
+    } else {
+        pool->misses++;
+        if (!growPool(pool)) {
+            return NULL;
+        }
+    }
+    struct pool_object *object = pool->freeList;
+    pool->freeList = object->next;
+    pool->inUse++;
+    return object;
+}
+
+void pool_put(struct pool *pool, void *object) {
+    struct pool_object *freed = object;
+    freed->next = pool->freeList;
+    pool->freeList = freed;
+    pool->inUse--;
+}
+
+void pool_print_stats(const struct pool *pool, FILE *out) {
+    fprintf(out, "Pool %s: size %lu, in use %lu, hits %lu, misses %lu, slabs %lu\n", pool->name,
+            (unsigned long) pool->objectSize, pool->inUse, pool->hits, pool->misses, pool->slabs);
+}
+
+void buffer_pools_init(struct buffer_pools *pools) {
+    for (int i = 0; i < BUFFER_CLASSES; ++i) {
+        pool_init(&pools->classes[i], bufferClassNames[i], bufferClassSizes[i]);
+    }
+}
+
+char *buffer_get(struct buffer_pools *pools, size_t size, size_t *capacity) {
+    for (int i = 0; i < BUFFER_CLASSES; ++i) {
+        if (size <= bufferClassSizes[i]) {
+            *capacity = bufferClassSizes[i];
+            return pool_get(&pools->classes[i]);
+        }
+    }
+    return NULL;
+}
+
+void buffer_put(struct buffer_pools *pools, char *buffer, size_t capacity) {
+    if (buffer == NULL) {
+        return;
+    }
+    for (int i = 0; i < BUFFER_CLASSES; ++i) {
+        if (capacity == bufferClassSizes[i]) {
+            pool_put(&pools->classes[i], buffer);
+            return;
+        }
+    }
+}
+
+void buffer_pools_print_stats(const struct buffer_pools *pools, FILE *out) {
+    for (int i = 0; i < BUFFER_CLASSES; ++i) {
+        pool_print_stats(&pools->classes[i], out);
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * file pool.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Slab pools for fixed size objects and size-classed buffers.
+ *
+ * @details A pool hands out objects of one size from slabs of POOL_SLAB_OBJECTS objects. Objects which are
+ * returned go to a free list and are reused, memory is never given back, so a server in steady state does
+ * not call malloc. Every pool counts hits (served from the free list) and misses (a new slab was needed).
+ **/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define POOL_SLAB_OBJECTS 64
+#define BUFFER_CLASSES 3
+
+struct pool_object {
+    struct pool_object *next;
+};
+
+struct pool {
+    const char *name;
+    size_t objectSize;
+    struct pool_object *freeList;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long inUse;
+    unsigned long slabs;
+};
+
+struct buffer_pools {
+    struct pool classes[BUFFER_CLASSES];
+};
+
+/**
+* @brief initialize a pool
+* @param pool: the pool
+* @param name: name which is printed in the statistics
+* @param objectSize: size of one object
+**/
+void pool_init(struct pool *pool, const char *name, size_t objectSize);
+
+/**
+* @brief get an object from the pool
+* @param pool: the pool
+* @return the object or NULL if no memory is left
+**/
+void *pool_get(struct pool *pool);
+
+/**
+* @brief return an object to the pool
+* @param pool: the pool
+* @param object: the object
+**/
+void pool_put(struct pool *pool, void *object);
+
+/**
+* @brief print the statistics of the pool
+* @param pool: the pool
+* @param out: stream to which the statistics are written
+**/
+void pool_print_stats(const struct pool *pool, FILE *out);
+
+/**
+* @brief initialize the buffer pools with the size classes 512, 2048 and 16384
+* @param pools: the buffer pools
+**/
+void buffer_pools_init(struct buffer_pools *pools);
+
+/**
+* @brief get a buffer of at least the requested size
+* @param pools: the buffer pools
+* @param size: requested size, at most the largest size class
+* @param capacity: set to the real size of the buffer
+* @return the buffer or NULL if no memory is left or the size is too large
+**/
+char *buffer_get(struct buffer_pools *pools, size_t size, size_t *capacity);
+
+/**
+* @brief return a buffer to its size class
+* @param pools: the buffer pools
+* @param buffer: the buffer, NULL is ignored
+* @param capacity: capacity returned by buffer_get
+**/
+void buffer_put(struct buffer_pools *pools, char *buffer, size_t capacity);
+
+/**
+* @brief print the statistics of all size classes
+* @param pools: the buffer pools
+* @param out: stream to which the statistics are written
+**/
+void buffer_pools_print_stats(const struct buffer_pools *pools, FILE *out);
+
+#endif
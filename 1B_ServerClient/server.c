@@ -1,19 +1,41 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/sendfile.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/time.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <time.h>
 #include <signal.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/openat2.h>
 #include <dirent.h>
 #include <errno.h>
+#include <ctype.h>
+#include <limits.h>
+#include <openssl/err.h>
+
+#include "timer.h"
+#include "pool.h"
+#include "hpack.h"
+#include "http2.h"
+#include "tls.h"
+#include "bundle.h"
+#include "shaper.h"
+#include "http1.h"
+#include "cache.h"
 
 
 
@@ -26,247 +48,2976 @@
  * @details The server waits for connections from clients and transmits the requested files.
  *Option -p can be used to specify the port on which the server shall listen for incoming connections.If this option is not used the port defaults to 8080 (port 80 requires root privileges).
  * Option -i is used to specify the index filename, i.e. the file which the server shall attempt to transmit if the request path is a directory. The default index filename is index.html.
+ * All connections are served by one epoll event loop. Every connection has a deadline in a timer wheel:
+ * the request header has to arrive within HEADER_TIMEOUT_MS, a response body must make progress within
+ * WRITE_TIMEOUT_MS and an idle keep-alive connection is closed after KEEPALIVE_TIMEOUT_MS.
+ * Connection objects and their buffers come from slab pools and are only held while a request is in
+ * progress, an idle connection needs no buffer at all. SIGUSR1 prints the pool statistics.
+ * Files up to SMALL_BODY_LEN are sent together with the response header in one sendmsg, larger files are
+ * sent with sendfile while the socket is corked, so the header and the first body bytes share a segment.
+ * Cleartext HTTP/2 is served to clients which start with the connection preface (prior knowledge) or ask
+ * for "Upgrade: h2c". Up to H2_MAX_STREAMS streams are multiplexed on one connection, they take turns
+ * frame by frame and respect the flow control windows of the client.
+ * With options -c and -k the server speaks HTTPS. The handshake is done with OpenSSL in user space, then
+ * the session keys are installed in the kernel (kTLS), so responses are still sent with sendmsg and
+ * sendfile and the kernel encrypts the records. If the kernel has no TLS support, or with option -s, the
+ * records are encrypted in user space and large files are copied through a buffer. HTTP/2 is negotiated
+ * with ALPN "h2" on TLS connections.
+ * SIGHUP or SIGUSR2 reload the server without refusing a single connection: the binary is started again
+ * and inherits the listening socket (LISTEN_FD_ENV), when it reports that it is ready (READY_FD_ENV) the
+ * old process stops accepting and drains its connections. Responses get "Connection: close", HTTP/2
+ * clients get a GOAWAY and idle connections run into their keep-alive timeout. After DRAIN_TIMEOUT_MS the
+ * remaining connections are closed.
+ * Request targets are percent-decoded and normalized in place ("." and ".." segments, repeated slashes)
+ * and opened relative to a descriptor of the document root with openat2 and RESOLVE_BENEATH, so neither
+ * ".." nor a symbolic link can leave the document root. Kernels without openat2 open the path component by
+ * component and follow no symbolic link at all. A directory is answered with its index file, a directory
+ * without an index file is listed. The listing is generated while it is sent, one chunk of
+ * "Transfer-Encoding: chunked" per body buffer, so the first bytes go out before the directory was read.
+ * With option -b the files are served from a bundle built by mkbundle instead of a document root. The
+ * bundle is mapped at startup, a request costs one probe in its hash index and no system call until the
+ * body is sent, small bodies are copied straight from the mapping and large ones are sent with sendfile
+ * from the bundle. Directory indexes are resolved when the bundle is built, so -i is not needed and there
+ * are no listings. A reload maps the bundle again, so a rebuilt bundle is picked up with SIGHUP.
+ * Responses are sent in turns of a deficit round robin: in every turn a connection may send SEND_QUANTUM
+ * bytes, bytes beyond it are taken from its next turn. A connection which used up its turn waits in the run
+ * queue behind all other connections which want to send, so a large download is sent quantum by quantum
+ * between the small responses of other clients. Option -r limits the send rate of every connection and
+ * option -R the send rate of every client address (token buckets, in KiB per second), a connection which
+ * ran out of tokens sleeps in the timer wheel until its buckets are refilled.
+ * With option -u HOST:PORT the server is a caching reverse proxy in front of another server and DOC_ROOT is
+ * its cache directory. A request is answered from the memory cache of small bodies or from the cache file
+ * of its path. A miss is fetched from the upstream server by a child process with the HTTP/1.1 code of the
+ * client, all requests for a path which is being fetched wait for the same fetch. The child writes the body
+ * into a temporary cache file and reports every piece on the fill pipe, so HTTP/1.1 responses of more than
+ * SMALL_BODY_LEN bytes are sent from the growing file while the fetch is still running. All other responses
+ * are answered when the file is complete. Only 200 responses with a Content-Length or a complete chunked
+ * body are cached, a body which just ends with the connection could have been cut off. A cache file is kept
+ * until it is deleted from the cache directory.
+ **/
+
+
+#define MAX_CHAR_LEN 2048
+#define REQUEST_BUFFER_LEN 2048
+#define RESPONSE_HEADER_LEN 512
+#define SMALL_BODY_LEN 16384
+#define CHUNK_HEADER_LEN 6 // chunk size as four hex digits and CRLF, so it can be written after the data
+#define CHUNK_TRAILER_LEN 7 // CRLF after the data and the last chunk "0\r\n\r\n"
+#define LISTING_ENTRY_LEN 2400 // one entry of a directory listing with a name of 255 bytes escaped
+#define SEND_QUANTUM 65536 // bytes which a connection may send in one turn of the scheduler
+#define FASTOPEN_QUEUE_LEN 256
+#define MAX_EVENTS 256
+#define CACHE_MEMORY_LEN (64 * 1024 * 1024) // bodies up to SMALL_BODY_LEN are also kept in memory
+#define FILL_BUFFER_LEN 65536 // bytes which an upstream fetch reads and reports at once
+
+#define H2_MAX_STREAMS 16
+#define H2_BUFFER_LEN 16384
+#define H2_MAX_HEADER_BLOCK 16384
+#define H2_CONTROL_RESERVE 64 // free output space which is needed to answer any control frame
+
+#define HEADER_TIMEOUT_MS 10000
+#define WRITE_TIMEOUT_MS 30000
+#define KEEPALIVE_TIMEOUT_MS 5000
+#define DRAIN_TIMEOUT_MS 30000
+#define UPSTREAM_TIMEOUT_MS 30000
+
+#define LISTEN_FD_ENV "SERVER_LISTEN_FD" // listening socket which is inherited after a reload
+#define READY_FD_ENV "SERVER_READY_FD" // pipe on which the new process reports that it accepts connections
+
+#define CONN_READ_HEADER 0
+#define CONN_WRITE_RESPONSE 1
+
+#define FILL_HEADER 0 // the upstream server answered, with status and size of the body or -1
+#define FILL_DATA 1 // size bytes of the body are in the temporary cache file
+#define FILL_DONE 2 // the cache file is complete, or the status is not 200 and nothing is cached
+#define FILL_FAILED 3
+#define FILL_UNCACHED 4 // the body ended with the connection, it is answered from the temporary file but not kept
+
+static char *program_name;
+static volatile sig_atomic_t isListening = 1;
+static volatile sig_atomic_t printStats = 0;
+static volatile sig_atomic_t reloadRequested = 0;
+static volatile sig_atomic_t childExited = 0;
+
+static char *docRoot;
+static char *indexFile;
+static int docRootFd; // the document root, all files are opened relative to it
+static struct bundle bundle = {.fd = -1}; // the mapped bundle with option -b, fd is -1 otherwise
+static int epollFd;
+static struct timer_wheel timers;
+static struct pool connectionPool;
+static struct pool sessionPool;
+static struct buffer_pools bufferPools;
+static SSL_CTX *tlsContext; // NULL while the server speaks plain HTTP
+static int draining = 0; // 1 after the listening socket was handed to a new process
+static int reloadPipe = -1; // read end of the readiness pipe of a starting new process or -1
+static pid_t reloadPid;
+static struct timer drainTimer;
+static long connectionRate = 0; // bytes per second of every connection with option -r, 0 without limit
+static struct client_table clients; // buckets of the client addresses, limited with option -R
+static struct connection *runQueueHead; // connections which wait for their next turn to send
+static struct connection *runQueueTail;
+static char *upstream; // HOST:PORT of the upstream server with option -u, NULL otherwise
+static char *upstreamHost;
+static char *upstreamPort;
+static struct cache_fill *fills; // running upstream fetches
+static uint32_t nextFillId;
+static int fillPipe[2] = {-1, -1}; // the fetch processes report their progress on it
+static struct memory_cache memoryCache;
+
+/**
+ * an upstream fetch of a cache miss, all requests for the path wait for the same fetch
+ **/
+struct cache_fill {
+    struct cache_fill *next;
+    uint32_t id;
+    pid_t pid; // process which fetches the path
+    char *path; // normalized path without leading slash
+    char tmpName[64]; // name of the cache file while it is written
+    long status; // status of the upstream response, 0 until it arrived
+    off_t size; // size of the body, -1 while it is unknown
+    off_t available; // bytes of the body which are in the cache file
+    struct connection **waiters; // connections which wait for the fetch or stream from it
+    size_t waiterCount;
+    size_t waiterCap;
+};
+
+/**
+ * progress report of a fetch process, it is written to the fill pipe in one piece
+ **/
+struct fill_message {
+    uint32_t id;
+    uint32_t type; // one of the FILL_ reports
+    int64_t status;
+    int64_t size;
+};
+
+/**
+ * state of one HTTP/2 stream
+ **/
+struct http2_stream {
+    uint32_t id; // 0 if the slot is free
+    const char *status;
+    int headersSent;
+    int fileFd; // requested file or -1 if the response has no body
+    off_t fileBase; // offset of the file in fileFd, only a file in the bundle does not start at 0
+    off_t fileOffset;
+    off_t fileSize;
+    long window; // flow control window of the client for this stream
+    struct cache_fill *fill; // upstream fetch which the stream waits for, its status is NULL meanwhile
+    DIR *listing; // directory which is listed in the DATA frames or NULL
+    char *body; // generated part of the listing which is not sent yet, NULL without listing
+    size_t bodyLen;
+    size_t bodySent;
+    size_t bodyCap;
+};
+
+/**
+ * state of a connection which was switched to HTTP/2
  **/
+struct http2_session {
+    struct connection *conn; // the connection of the session
+    struct hpack_table decoder;
+    unsigned char *in; // received bytes which are not processed yet
+    size_t inLen;
+    size_t inCap;
+    unsigned char *out; // frames which are not sent yet
+    size_t outLen;
+    size_t outSent;
+    size_t outCap;
+    unsigned char *headerBlock; // header block which is continued by CONTINUATION frames
+    size_t headerBlockLen;
+    size_t headerBlockCap;
+    uint32_t headerStream; // stream of the unfinished header block or 0
+    size_t discard; // payload bytes of a DATA frame which are still dropped
+    int prefaceReceived;
+    long window; // flow control window of the client for the connection
+    long peerInitialWindow;
+    uint32_t peerMaxFrameSize;
+    uint32_t lastStreamId;
+    int goaway; // 1 if no new streams are accepted
+    int activeStreams;
+    int nextStream; // stream slot which starts the next round of frames
+    struct http2_stream streams[H2_MAX_STREAMS];
+};
+
+/**
+ * state of one client connection
+ **/
+struct connection {
+    int fd;
+    int state;
+    int keepAlive; // 1 if the connection is kept open after the response
+    struct timer timer; // header-read, body-write or keep-alive deadline
+    char *request; // received bytes of the request header, NULL while no request is pending
+    size_t requestLen;
+    size_t requestCap;
+    char *response; // response header which is sent before the body, NULL while idle
+    size_t responseLen;
+    size_t responseCap;
+    size_t responseSent; // sent bytes of the response header and the body buffer
+    char *body; // content of a small file which is sent together with the header, NULL otherwise
+    size_t bodyLen;
+    size_t bodyCap;
+    int fileFd; // requested file or -1 if the response has no body
+    off_t fileBase; // offset of the file in fileFd, only a file in the bundle does not start at 0
+    off_t fileOffset;
+    off_t fileSize;
+    DIR *listing; // directory which is listed in the chunked body or NULL
+    struct http2_session *h2; // NULL while the connection speaks HTTP/1.1
+    SSL *ssl; // NULL for plain HTTP connections
+    int kernelTls; // 1 if the kernel encrypts what is written to the socket
+    uint32_t events; // events which epoll reports for the connection
+    long deficit; // bytes which the connection may still send in its turn, negative if it sent more
+    int throttled; // 1 if the last send stopped at the deficit or at a bucket
+    int queued; // 1 while the connection is in the run queue
+    struct connection *runPrev;
+    struct connection *runNext;
+    struct timer shapeTimer; // wakes the connection when its buckets have tokens again
+    struct token_bucket bucket; // send rate of the connection
+    struct client_limit *client; // send rate of the client address or NULL without limit
+    struct cache_fill *fill; // upstream fetch which the response waits for or streams from, NULL otherwise
+    int fillFailed; // 1 if the fetch of the streamed body failed, the connection is closed in its next turn
+};
+
+/**
+* @brief checks if the Port is valid
+* @details a vaild Port must be between 1 and 65535
+* @param strPort: Port as a String
+**/
+static void checkValidPort(char *strPort) {
+    char *ptr;
+    long port;
+    port = strtol(strPort, &ptr, 10);
+    if (port < 1 || port > 65535) {
+        fprintf(stderr, "Error in %s:Port must be between 1 and 65535 \n", program_name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/**
+* @brief checks if options are correct
+* @details checks if options are correct and if each option ist only one time given
+* @param p: option p
+* @param i: option i
+* @param c: option c
+* @param k: option k
+* @param b: option b
+* @param r: option r
+* @param R: option R
+* @param u: option u
+**/
+static void checkOptions(int p, int i, int c, int k, int b, int r, int R, int u) {
+    if (p > 1) {
+        fprintf(stderr, "Error in %s: Too many Ports\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (i > 1) {
+        fprintf(stderr, "Error in %s: Too many index \n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (c > 1 || k > 1) {
+        fprintf(stderr, "Error in %s: Too many certificates or keys\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (c != k) {
+        fprintf(stderr, "Error in %s: HTTPS needs a certificate (-c) and a key (-k)\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (b > 1) {
+        fprintf(stderr, "Error in %s: Too many bundles\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (b > 0 && i > 0) {
+        fprintf(stderr, "Error in %s: The index of a bundle is chosen by mkbundle -i\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (r > 1 || R > 1) {
+        fprintf(stderr, "Error in %s: Too many rate limits\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (u > 1) {
+        fprintf(stderr, "Error in %s: Too many upstream servers\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (u > 0 && (b > 0 || i > 0)) {
+        fprintf(stderr, "Error in %s: A proxy serves neither a bundle nor index files\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+* @brief parses a rate limit
+* @details a rate must be a positive number of KiB per second
+* @param strRate: rate as a String
+* @return the rate in bytes per second
+**/
+static long parseRate(char *strRate) {
+    char *ptr;
+    long rate = strtol(strRate, &ptr, 10);
+    if (isdigit((unsigned char) strRate[0]) == 0 || *ptr != '\0' || rate < 1 || rate > LONG_MAX / 1024 / 1000) {
+        fprintf(stderr, "Error in %s: Rate must be a positive number of KiB per second\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    return rate * 1024;
+}
+
+/**
+* @brief parses the upstream server of the proxy mode
+* @details the host may be an IPv6 address in brackets, the port has to be valid
+* @param strUpstream: HOST:PORT as a String
+**/
+static void parseUpstream(char *strUpstream) {
+    char *colon = strrchr(strUpstream, ':');
+    if (colon == NULL || colon == strUpstream || colon[1] == '\0') {
+        fprintf(stderr, "Error in %s: Upstream must be HOST:PORT\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    char *host = strUpstream;
+    size_t hostLen = colon - strUpstream;
+    if (host[0] == '[' && hostLen >= 2 && host[hostLen - 1] == ']') {
+        host++;
+        hostLen -= 2;
+    }
+    upstreamHost = strndup(host, hostLen);
+    if (upstreamHost == NULL) {
+        fprintf(stderr, "Error in %s: malloc failed\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    upstreamPort = colon + 1;
+    checkValidPort(upstreamPort);
+    upstream = strUpstream;
+}
+
+/**
+* @brief set the current Date
+* @details set the current Date and Time
+* @param date: variable in which the Date will be saved
+* @param dateLen: size of the variable
+**/
+static void setCurrentDate(char *date, size_t dateLen) {
+    time_t now = time(&now);
+    struct tm *tm = gmtime(&now);
+    strftime(date, dateLen, "%a, %d %b %y %H:%M:%S %Z", tm);
+}
+
+/**
+* @brief sets the interest of the connection in the event loop
+* @param conn: the connection
+* @param events: EPOLLIN, EPOLLOUT or 0 while the connection waits for its turn
+**/
+static void watchConnection(struct connection *conn, uint32_t events) {
+    if (conn->events == events) {
+        return;
+    }
+    conn->events = events;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = events;
+    ev.data.ptr = conn;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+/**
+* @brief appends a connection to the run queue
+* @param conn: the connection
+**/
+static void enqueueConnection(struct connection *conn) {
+    if (conn->queued) {
+        return;
+    }
+    conn->queued = 1;
+    conn->runNext = NULL;
+    conn->runPrev = runQueueTail;
+    if (runQueueTail != NULL) {
+        runQueueTail->runNext = conn;
+    } else {
+        runQueueHead = conn;
+    }
+    runQueueTail = conn;
+}
+
+/**
+* @brief removes a connection from the run queue, it is safe to remove a connection which is not queued
+* @param conn: the connection
+**/
+static void dequeueConnection(struct connection *conn) {
+    if (!conn->queued) {
+        return;
+    }
+    conn->queued = 0;
+    if (conn->runPrev != NULL) {
+        conn->runPrev->runNext = conn->runNext;
+    } else {
+        runQueueHead = conn->runNext;
+    }
+    if (conn->runNext != NULL) {
+        conn->runNext->runPrev = conn->runPrev;
+    } else {
+        runQueueTail = conn->runPrev;
+    }
+}
+
+/**
+* @brief returns the number of bytes which the connection may send now
+* @details the smallest of the deficit of its turn and the tokens of its buckets, the bytes of one send
+* may exceed it. If nothing may be sent the connection is marked as throttled.
+* @param conn: the connection
+* @return the number of bytes, 0 or less if the connection has to wait
+**/
+static long sendAllowance(struct connection *conn) {
+    long allowance = conn->deficit;
+    if (connectionRate != 0 || conn->client != NULL) {
+        uint64_t now = shaper_now();
+        long tokens = token_bucket_available(&conn->bucket, now);
+        allowance = tokens < allowance ? tokens : allowance;
+        if (conn->client != NULL) {
+            tokens = token_bucket_available(&conn->client->bucket, now);
+            allowance = tokens < allowance ? tokens : allowance;
+        }
+    }
+    conn->throttled = allowance <= 0;
+    return allowance;
+}
+
+/**
+* @brief charges sent bytes to the turn and the buckets of the connection
+* @param conn: the connection
+* @param bytes: number of sent bytes
+**/
+static void chargeConnection(struct connection *conn, long bytes) {
+    conn->deficit -= bytes;
+    token_bucket_take(&conn->bucket, bytes);
+    if (conn->client != NULL) {
+        token_bucket_take(&conn->client->bucket, bytes);
+    }
+}
+
+/**
+* @brief lets a throttled connection wait for its next turn
+* @details a connection which used up its deficit is queued behind all other connections which want to
+* send, a connection which ran out of tokens sleeps until its buckets hold a quantum or their burst
+* @param conn: the connection
+**/
+static void scheduleConnection(struct connection *conn) {
+    unsigned long delay = 0;
+    if (conn->deficit > 0) {
+        long want = conn->bucket.burst < SEND_QUANTUM ? conn->bucket.burst : SEND_QUANTUM;
+        delay = token_bucket_delay(&conn->bucket, want);
+        if (conn->client != NULL) {
+            want = conn->client->bucket.burst < SEND_QUANTUM ? conn->client->bucket.burst : SEND_QUANTUM;
+            unsigned long clientDelay = token_bucket_delay(&conn->client->bucket, want);
+            delay = clientDelay > delay ? clientDelay : delay;
+        }
+    }
+    if (delay > 0) {
+        timer_arm(&timers, &conn->shapeTimer, delay);
+    } else {
+        enqueueConnection(conn);
+    }
+}
+
+/**
+* @brief called when the buckets of a sleeping connection have tokens again
+* @param timer: shape timer of the connection
+**/
+static void shapeTimeout(struct timer *timer) {
+    struct connection *conn = (struct connection *) ((char *) timer - offsetof(struct connection, shapeTimer));
+    enqueueConnection(conn);
+}
+
+/**
+* @brief returns the buffers of a connection which are not needed any more to the pools
+* @param conn: the connection
+**/
+static void releaseBuffers(struct connection *conn) {
+    if (conn->requestLen == 0) { // keep the buffer if pipelined bytes of the next request are in it
+        buffer_put(&bufferPools, conn->request, conn->requestCap);
+        conn->request = NULL;
+    }
+    buffer_put(&bufferPools, conn->response, conn->responseCap);
+    conn->response = NULL;
+    conn->responseLen = 0;
+    conn->responseSent = 0;
+    buffer_put(&bufferPools, conn->body, conn->bodyCap);
+    conn->body = NULL;
+    conn->bodyLen = 0;
+}
+
+/**
+* @brief sets or clears TCP_CORK on the connection
+* @details while the socket is corked only full segments are sent
+* @param conn: the connection
+* @param cork: 1 to cork and 0 to send the pending partial segment
+**/
+static void corkConnection(struct connection *conn, int cork) {
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_CORK, &cork, sizeof cork);
+}
+
+/**
+* @brief reads from the connection
+* @details TLS records are decrypted by OpenSSL, errors are reported like recv does
+* @param conn: the connection
+* @param buffer: buffer for the received bytes
+* @param len: size of the buffer
+* @return number of received bytes, 0 if the client closed the connection or -1 with errno set
+**/
+static ssize_t connectionRecv(struct connection *conn, void *buffer, size_t len) {
+    if (conn->ssl == NULL) {
+        return recv(conn->fd, buffer, len, 0);
+    }
+    // SSL_get_error looks at the error queue of the thread first, which is shared by all connections
+    ERR_clear_error();
+    int n = SSL_read(conn->ssl, buffer, len);
+    if (n > 0) {
+        return n;
+    }
+    switch (SSL_get_error(conn->ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            errno = EAGAIN;
+            return -1;
+        case SSL_ERROR_ZERO_RETURN:
+            return 0;
+        default:
+            errno = ECONNRESET;
+            return -1;
+    }
+}
+
+/**
+* @brief writes to the connection
+* @details plain and kernel TLS connections send all buffers with one sendmsg, with TLS in user space only the
+* first buffer is encrypted and sent
+* @param conn: the connection
+* @param msg: the buffers
+* @param flags: flags for sendmsg
+* @return number of sent bytes or -1 with errno set
+**/
+static ssize_t connectionSend(struct connection *conn, struct msghdr *msg, int flags) {
+    if (conn->ssl == NULL || conn->kernelTls) {
+        ssize_t n = sendmsg(conn->fd, msg, flags);
+        if (n > 0) {
+            chargeConnection(conn, n);
+        }
+        return n;
+    }
+    ERR_clear_error(); // an old error of another connection would turn SSL_ERROR_WANT_WRITE into a failure
+    int n = SSL_write(conn->ssl, msg->msg_iov[0].iov_base, msg->msg_iov[0].iov_len);
+    if (n > 0) {
+        chargeConnection(conn, n);
+        return n;
+    }
+    int error = SSL_get_error(conn->ssl, n);
+    errno = (error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ) ? EAGAIN : EPIPE;
+    return -1;
+}
+
+/**
+* @brief closes a requested File
+* @details the bundle is shared by all requests and stays open
+* @param fileFd: the requested File
+**/
+static void closeFile(int fileFd) {
+    if (fileFd != bundle.fd) {
+        close(fileFd);
+    }
+}
+
+/**
+* @brief removes a connection from the waiters of all upstream fetches
+* @param conn: the connection
+**/
+static void forgetWaiter(struct connection *conn) {
+    for (struct cache_fill *fill = fills; fill != NULL; fill = fill->next) {
+        size_t kept = 0;
+        for (size_t i = 0; i < fill->waiterCount; ++i) {
+            if (fill->waiters[i] != conn) {
+                fill->waiters[kept++] = fill->waiters[i];
+            }
+        }
+        fill->waiterCount = kept;
+    }
+}
+
+/**
+* @brief closes the connection
+* @details closes the connection, the requested file and cancels the deadline of the connection
+* @param conn: the connection
+**/
+static void closeConnection(struct connection *conn) {
+    forgetWaiter(conn);
+    timer_cancel(&timers, &conn->timer);
+    timer_cancel(&timers, &conn->shapeTimer);
+    dequeueConnection(conn);
+    client_table_put(&clients, conn->client);
+    if (conn->fileFd >= 0) {
+        closeFile(conn->fileFd);
+    }
+    if (conn->listing != NULL) {
+        closedir(conn->listing);
+    }
+    if (conn->ssl != NULL) {
+        if (SSL_is_init_finished(conn->ssl)) {
+            SSL_shutdown(conn->ssl); // best effort close_notify, the socket is not waited for
+        }
+        SSL_free(conn->ssl);
+    }
+    close(conn->fd); // also removes the fd from the epoll set
+    conn->requestLen = 0;
+    releaseBuffers(conn);
+    if (conn->h2 != NULL) {
+        for (int i = 0; i < H2_MAX_STREAMS; ++i) {
+            struct http2_stream *stream = &conn->h2->streams[i];
+            if (stream->id != 0 && stream->fileFd >= 0) {
+                closeFile(stream->fileFd);
+            }
+            if (stream->id != 0 && stream->listing != NULL) {
+                closedir(stream->listing);
+            }
+            if (stream->id != 0 && stream->body != NULL) {
+                buffer_put(&bufferPools, stream->body, stream->bodyCap);
+            }
+        }
+        buffer_put(&bufferPools, (char *) conn->h2->in, conn->h2->inCap);
+        buffer_put(&bufferPools, (char *) conn->h2->out, conn->h2->outCap);
+        buffer_put(&bufferPools, (char *) conn->h2->headerBlock, conn->h2->headerBlockCap);
+        pool_put(&sessionPool, conn->h2);
+    }
+    pool_put(&connectionPool, conn);
+}
+
+/**
+* @brief called when the deadline of a connection expired
+* @param timer: timer of the connection
+**/
+static void connectionTimeout(struct timer *timer) {
+    struct connection *conn = (struct connection *) ((char *) timer - offsetof(struct connection, timer));
+    if (conn->state == CONN_READ_HEADER && conn->requestLen > 0) {
+        fprintf(stderr, "Request Header Timeout - Closed Connection to Client\n");
+    }
+    closeConnection(conn);
+}
+
+/**
+* @brief prepares a Http Response Error
+* @details prepares a Http Response Error with a specific Error message, the connection is closed after it was sent
+* @param conn: the connection
+* @param errorMsg: errorMsg which will be send
+**/
+static void sendHttpResponseError(struct connection *conn, char *errorMsg) {
+    fprintf(stderr, "Get Request from Client - Send Response with Status %s\n", errorMsg);
+    conn->keepAlive = 0;
+    conn->responseSent = 0;
+    conn->responseLen = 0;
+    if (conn->response == NULL) { // without a buffer the connection is just closed
+        return;
+    }
+    conn->responseLen = snprintf(conn->response, conn->responseCap, "HTTP/1.1 %s\r\n"
+                                                                    "Connection: close\r\n\r\n", errorMsg);
+}
+
+/**
+* @brief prepares a Http Response Header
+* @details prepares a Http Response Header with a specific filesize
+* @param conn: the connection
+* @param fileSize: size from the response File or -1 for a generated HTML body with chunked encoding
+**/
+static void sendHttpResponseHeader(struct connection *conn, off_t fileSize) {
+    fprintf(stderr, "Get Request from Client - Send Response with Status 200 OK\n");
+    char date[64];
+    setCurrentDate(date, sizeof(date));
+
+    conn->responseSent = 0;
+    if (fileSize < 0) {
+        conn->responseLen = snprintf(conn->response, conn->responseCap, "HTTP/1.1 200 OK\r\n"
+                                                                        "Date: %s\r\n"
+                                                                        "Content-Type: text/html; charset=utf-8\r\n"
+                                                                        "Transfer-Encoding: chunked\r\n"
+                                                                        "Connection: %s\r\n\r\n",
+                                     date, conn->keepAlive ? "keep-alive" : "close");
+        return;
+    }
+    conn->responseLen = snprintf(conn->response, conn->responseCap, "HTTP/1.1 200 OK\r\n"
+                                                                    "Date: %s\r\n"
+                                                                    "Content-Length: %lld\r\n"
+                                                                    "Connection: %s\r\n\r\n",
+                                 date, (long long) fileSize, conn->keepAlive ? "keep-alive" : "close");
+}
+
+/**
+* @brief checks the fist line of the Http Request Header
+* @details checks the fist line of the Http Request Header if the request method and the protocol is correct
+* @param conn: the connection
+* @param header_line: first line of the header without the line break
+* @param requestFilename: set to the filename from the requested File inside header_line
+* @return 1 if the Header is correct  and 0 if the Header is not correct and a error message was prepared
+**/
+static int checkRequestHeaderAndGetFilename(struct connection *conn, char *header_line, char **requestFilename) {
+    char *requestMethod;
+    requestMethod = strtok(header_line, " ");
+    char *filename;
+    filename = strtok(NULL, " ");
+
+    if (requestMethod == NULL || filename == NULL) {
+        char *errorMsg = "400 Bad Request";
+        sendHttpResponseError(conn, errorMsg);
+        return 0;
+    }
+
+    *requestFilename = filename;
+
+    if (strcmp(requestMethod, "GET") != 0) {
+        char *errorMsg = "501 Not implemented";
+        sendHttpResponseError(conn, errorMsg);
+        return 0;
+    }
+
+    char *protocol;
+    protocol = strtok(NULL, " ");
+
+    if (protocol == NULL || strcmp(protocol, "HTTP/1.1") != 0) {
+        char *errorMsg = "400 Bad Request";
+        sendHttpResponseError(conn, errorMsg);
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+* @brief checks if a String contains a word
+* @details compares case-insensitive, as Http header values are case-insensitive
+* @param str: String which is searched
+* @param word: word which is searched for
+* @return 1 if the String contains the word and else returns 0
+**/
+static int containsIgnoreCase(const char *str, const char *word) {
+    size_t wordLen = strlen(word);
+    for (; *str != '\0'; ++str) {
+        if (strncasecmp(str, word, wordLen) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+* @brief reads the Header from the request
+* @details reads the Header lines after the status line and checks if the client wants to close the connection
+* or to upgrade to HTTP/2
+* @param conn: the connection
+* @param headerLines: header lines after the first line, terminated by an empty line
+* @param http2Settings: set to the value of the HTTP2-Settings header if the client asks for "Upgrade: h2c" with
+* exactly one HTTP2-Settings header and else NULL
+*/
+static void readRequestHeaderLines(struct connection *conn, char *headerLines, char **http2Settings) {
+    conn->keepAlive = 1; // persistent connections are the default in HTTP/1.1
+    int upgradeH2c = 0;
+    int settingsCount = 0;
+    char *settings = NULL;
+    char *line = headerLines;
+    char *end;
+    while ((end = strstr(line, "\r\n")) != NULL && end != line) {
+        *end = '\0';
+        if (strncasecmp(line, "Connection:", strlen("Connection:")) == 0 && containsIgnoreCase(line, "close")) {
+            conn->keepAlive = 0;
+        } else if (strncasecmp(line, "Upgrade:", strlen("Upgrade:")) == 0 && containsIgnoreCase(line, "h2c")) {
+            upgradeH2c = 1;
+        } else if (strncasecmp(line, "HTTP2-Settings:", strlen("HTTP2-Settings:")) == 0) {
+            settings = line + strlen("HTTP2-Settings:");
+            settings += strspn(settings, " \t");
+            for (char *last = end - 1; last >= settings && (*last == ' ' || *last == '\t'); --last) {
+                *last = '\0';
+            }
+            settingsCount++;
+        }
+        line = end + 2;
+    }
+    *http2Settings = upgradeH2c && settingsCount == 1 ? settings : NULL;
+}
+
+
+/**
+* @brief returns the value of a hex digit
+* @param c: the digit
+* @return the value or -1 if c is no hex digit
+*/
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+* @brief normalizes a request target in place
+* @details drops the query, decodes percent-encoded bytes and removes empty, "." and ".." segments, ".." in
+* the document root stays in the document root. The result is relative to the document root without a
+* leading slash and is empty for the document root itself.
+* @param path: the request target, it has to start with a slash
+* @return 1 on success and 0 if the target is malformed
+*/
+static int normalizeRequestPath(char *path) {
+    if (path[0] != '/') {
+        return 0;
+    }
+    path[strcspn(path, "?#")] = '\0';
+
+    char *in = path;
+    char *out = path;
+    while (*in != '\0') {
+        if (*in == '%') {
+            int high = hexValue(in[1]);
+            int low = high >= 0 ? hexValue(in[2]) : -1;
+            if (low < 0 || (high == 0 && low == 0)) { // broken escape or a NUL byte
+                return 0;
+            }
+            *out++ = (char) (high * 16 + low);
+            in += 3;
+        } else {
+            *out++ = *in++;
+        }
+    }
+    *out = '\0';
+
+    // the written part never overtakes the read part, every segment moves to the left
+    char *read = path;
+    char *write = path;
+    while (*read != '\0') {
+        read += strspn(read, "/");
+        char *segment = read;
+        size_t len = strcspn(segment, "/");
+        read += len;
+        if (len == 0 || (len == 1 && segment[0] == '.')) {
+            continue;
+        }
+        if (len == 2 && segment[0] == '.' && segment[1] == '.') {
+            while (write > path && write[-1] != '/') {
+                write--;
+            }
+            if (write > path) {
+                write--;
+            }
+            continue;
+        }
+        if (write > path) {
+            *write++ = '/';
+        }
+        memmove(write, segment, len);
+        write += len;
+    }
+    *write = '\0';
+    return 1;
+}
+
+/**
+* @brief opens a path below a directory without openat2
+* @details every component is opened with O_NOFOLLOW relative to the previous one, so a symbolic link is
+* refused instead of followed and ".." is refused as well
+* @param dirFd: the directory
+* @param path: relative path
+* @return the file descriptor or -1 on error
+*/
+static int openComponents(int dirFd, const char *path) {
+    char component[NAME_MAX + 1];
+    int fd = dirFd;
+    for (;;) {
+        size_t len = strcspn(path, "/");
+        if (len > NAME_MAX || (len == 2 && strncmp(path, "..", 2) == 0)) {
+            errno = len > NAME_MAX ? ENAMETOOLONG : EACCES;
+            break;
+        }
+        memcpy(component, path, len);
+        component[len] = '\0';
+        int last = path[len] == '\0';
+        int next = openat(fd, component, O_RDONLY | O_CLOEXEC | O_NOFOLLOW | (last ? 0 : O_DIRECTORY));
+        if (fd != dirFd) {
+            close(fd);
+        }
+        if (next < 0 || last) {
+            return next;
+        }
+        fd = next;
+        path += len + 1;
+    }
+    if (fd != dirFd) {
+        close(fd);
+    }
+    return -1;
+}
+
+/**
+* @brief opens a path below a directory
+* @details openat2 with RESOLVE_BENEATH refuses every path which leaves the directory, also through symbolic
+* links. Kernels before 5.6 open the path component by component and follow no symbolic link.
+* @param dirFd: the directory
+* @param path: relative path
+* @return the file descriptor or -1 on error
+*/
+static int openBeneath(int dirFd, const char *path) {
+    static int haveOpenat2 = 1;
+    if (haveOpenat2) {
+        struct open_how how;
+        memset(&how, 0, sizeof how);
+        how.flags = O_RDONLY | O_CLOEXEC;
+        how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+        int fd = syscall(SYS_openat2, dirFd, path, &how, sizeof how);
+        if (fd >= 0 || errno != ENOSYS) {
+            return fd;
+        }
+        haveOpenat2 = 0;
+    }
+    return openComponents(dirFd, path);
+}
+
+/**
+* @brief opens the requested File
+* @details the target is normalized in place, for a directory its index file is opened. A proxy opens the
+* cache file of the path.
+* @param requestFilename: filename from the request
+* @param fileBase: set to the offset of the File in the returned file descriptor
+* @param fileSize: set to the size of the File
+* @param listing: set to a directory without index file which is listed instead, NULL if listings are not
+* supported
+* @return the file descriptor, -1 if the File does not exist or is no regular File, -2 if the target is
+* malformed and -3 if the directory in listing is listed
+*/
+static int openRequestedFile(char *requestFilename, off_t *fileBase, off_t *fileSize, DIR **listing) {
+    if (!normalizeRequestPath(requestFilename)) {
+        return -2;
+    }
+    *fileBase = 0;
+    if (upstream != NULL) {
+        return cache_open(docRootFd, requestFilename, fileBase, fileSize);
+    }
+    if (bundle.fd >= 0) {
+        const struct bundle_entry *entry = bundle_lookup(&bundle, requestFilename, strlen(requestFilename));
+        if (entry == NULL || (entry->flags & BUNDLE_ENTRY_NO_INDEX)) {
+            return -1;
+        }
+        *fileBase = entry->offset;
+        *fileSize = entry->size;
+        return bundle.fd;
+    }
+
+    struct stat st;
+    int fileFd = openBeneath(docRootFd, requestFilename[0] != '\0' ? requestFilename : ".");
+    if (fileFd < 0) {
+        return -1;
+    }
+    if (fstat(fileFd, &st) < 0) {
+        close(fileFd);
+        return -1;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        int indexFd = openBeneath(fileFd, indexFile);
+        if (indexFd < 0 && errno == ENOENT && listing != NULL) {
+            *listing = fdopendir(fileFd);
+            if (*listing == NULL) {
+                close(fileFd);
+                return -1;
+            }
+            return -3;
+        }
+        close(fileFd);
+        fileFd = indexFd;
+        if (fileFd < 0) {
+            return -1;
+        }
+        if (fstat(fileFd, &st) < 0) {
+            close(fileFd);
+            return -1;
+        }
+    }
+    if (!S_ISREG(st.st_mode)) {
+        close(fileFd);
+        return -1;
+    }
+    *fileSize = st.st_size;
+    return fileFd;
+}
+
+/**
+* @brief reads a small File into a body buffer
+* @details a File in the bundle is copied from the mapping
+* @param conn: the connection
+* @param fileFd: the requested File
+* @param fileBase: offset of the File in fileFd
+* @param fileSize: size of the File, at most SMALL_BODY_LEN
+* @return 1 if the whole File was read and else returns 0
+*/
+static int readSmallBody(struct connection *conn, int fileFd, off_t fileBase, off_t fileSize) {
+    if (fileSize == 0) {
+        return 1;
+    }
+    conn->body = buffer_get(&bufferPools, fileSize, &conn->bodyCap);
+    if (conn->body == NULL) {
+        return 0;
+    }
+    if (fileFd == bundle.fd) {
+        memcpy(conn->body, bundle.map + fileBase, fileSize);
+        conn->bodyLen = fileSize;
+        return 1;
+    }
+    while (conn->bodyLen < (size_t) fileSize) {
+        ssize_t n = pread(fileFd, conn->body + conn->bodyLen, fileSize - conn->bodyLen, fileBase + conn->bodyLen);
+        if (n <= 0) { // read error or the file was truncated, let sendfile deal with it
+            buffer_put(&bufferPools, conn->body, conn->bodyCap);
+            conn->body = NULL;
+            conn->bodyLen = 0;
+            return 0;
+        }
+        conn->bodyLen += n;
+    }
+    return 1;
+}
+
+/**
+* @brief appends a name to a listing, percent-encoded for an URL
+* @param out: end of the listing
+* @param name: the name
+* @return the number of written bytes, at most three times the length of the name
+*/
+static size_t appendUrlEncoded(char *out, const char *name) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t len = 0;
+    for (const unsigned char *c = (const unsigned char *) name; *c != '\0'; ++c) {
+        if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+            strchr("-._~/", *c) != NULL) {
+            out[len++] = *c;
+        } else {
+            out[len++] = '%';
+            out[len++] = hex[*c >> 4];
+            out[len++] = hex[*c & 15];
+        }
+    }
+    return len;
+}
+
+/**
+* @brief appends a name to a listing, escaped for HTML
+* @param out: end of the listing
+* @param name: the name
+* @return the number of written bytes, at most six times the length of the name
+*/
+static size_t appendHtmlEscaped(char *out, const char *name) {
+    size_t len = 0;
+    for (const char *c = name; *c != '\0'; ++c) {
+        const char *entity = *c == '<' ? "&lt;" : *c == '>' ? "&gt;" : *c == '&' ? "&amp;" :
+                             *c == '"' ? "&quot;" : *c == '\'' ? "&#39;" : NULL;
+        if (entity != NULL) {
+            memcpy(out + len, entity, strlen(entity));
+            len += strlen(entity);
+        } else {
+            out[len++] = *c;
+        }
+    }
+    return len;
+}
+
+/**
+* @brief finishes a chunk in the body buffer
+* @details the data was written after CHUNK_HEADER_LEN bytes, the size is written in front of it
+* @param conn: the connection
+* @param len: end of the data in the body buffer
+* @param last: 1 to append the last chunk
+*/
+static void finishChunk(struct connection *conn, size_t len, int last) {
+    char size[CHUNK_HEADER_LEN + 1];
+    snprintf(size, sizeof size, "%04lx\r\n", (unsigned long) (len - CHUNK_HEADER_LEN));
+    memcpy(conn->body, size, CHUNK_HEADER_LEN);
+    memcpy(conn->body + len, "\r\n", 2);
+    len += 2;
+    if (last) {
+        memcpy(conn->body + len, "0\r\n\r\n", 5);
+        len += 5;
+    }
+    conn->bodyLen = len;
+    conn->responseSent = conn->responseLen;
+}
+
+/**
+* @brief writes the head of the HTML page of a listing, the base of the links is the directory itself
+* @details the path of a request header fits twice into a body buffer even if every byte is percent-encoded
+* @param out: the buffer
+* @param path: normalized path of the directory
+* @return the number of written bytes
+*/
+static size_t writeListingHead(char *out, const char *path) {
+    size_t len = sprintf(out, "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><base href=\"/");
+    len += appendUrlEncoded(out + len, path);
+    len += sprintf(out + len, "%s\"></head>\n<body><h1>Index of /", path[0] != '\0' ? "/" : "");
+    len += appendUrlEncoded(out + len, path);
+    len += sprintf(out + len, "%s</h1>\n<ul>\n", path[0] != '\0' ? "/" : "");
+    return len;
+}
+
+/**
+* @brief writes the next entries of a listing
+* @details entries are read until the buffer is full, after the last entry the end of the page follows and
+* the directory is closed
+* @param listing: the listed directory, set to NULL when it was closed
+* @param out: the buffer
+* @param cap: size of the buffer, at least LISTING_ENTRY_LEN
+* @return the number of written bytes
+*/
+static size_t writeListingEntries(DIR **listing, char *out, size_t cap) {
+    size_t len = 0;
+    struct dirent *entry = NULL;
+    while (len + LISTING_ENTRY_LEN <= cap && (entry = readdir(*listing)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        int isDir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isDir = fstatat(dirfd(*listing), entry->d_name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+        }
+        len += sprintf(out + len, "<li><a href=\"");
+        len += appendUrlEncoded(out + len, entry->d_name);
+        len += sprintf(out + len, "%s\">", isDir ? "/" : "");
+        len += appendHtmlEscaped(out + len, entry->d_name);
+        len += sprintf(out + len, "%s</a></li>\n", isDir ? "/" : "");
+    }
+    if (entry == NULL && len + LISTING_ENTRY_LEN <= cap) {
+        len += sprintf(out + len, "</ul>\n</body></html>\n");
+        closedir(*listing);
+        *listing = NULL;
+    }
+    return len;
+}
+
+/**
+* @brief starts the listing of a directory
+* @details the first chunk holds the head of the HTML page
+* @param conn: the connection
+* @param path: normalized path of the directory
+* @return 1 on success and 0 if no memory is left
+*/
+static int startListing(struct connection *conn, const char *path) {
+    conn->body = buffer_get(&bufferPools, SMALL_BODY_LEN, &conn->bodyCap);
+    if (conn->body == NULL) {
+        return 0;
+    }
+    finishChunk(conn, CHUNK_HEADER_LEN + writeListingHead(conn->body + CHUNK_HEADER_LEN, path), 0);
+    conn->responseSent = 0;
+    return 1;
+}
+
+/**
+* @brief writes the next chunk of a directory listing into the body buffer
+* @details after the last entry the last chunk follows
+* @param conn: the connection
+*/
+static void produceListingChunk(struct connection *conn) {
+    size_t len = writeListingEntries(&conn->listing, conn->body + CHUNK_HEADER_LEN,
+                                     conn->bodyCap - CHUNK_HEADER_LEN - CHUNK_TRAILER_LEN);
+    finishChunk(conn, CHUNK_HEADER_LEN + len, conn->listing == NULL);
+}
+
+/**
+* @brief prepares the response with a File
+* @details a small File is read into the body buffer and sent together with the header, a larger one is
+* sent with sendfile
+* @param conn: the connection, it has a response buffer
+* @param fileFd: the File, the connection takes it over
+* @param fileBase: offset of the File in fileFd
+* @param fileSize: size of the File
+*/
+static void respondWithFile(struct connection *conn, int fileFd, off_t fileBase, off_t fileSize) {
+    if (fileSize <= SMALL_BODY_LEN && readSmallBody(conn, fileFd, fileBase, fileSize)) {
+        closeFile(fileFd);
+    } else {
+        conn->fileFd = fileFd;
+        conn->fileBase = fileBase;
+        conn->fileOffset = 0;
+        conn->fileSize = fileSize;
+        corkConnection(conn, 1);
+    }
+    sendHttpResponseHeader(conn, fileSize);
+}
+
+/**
+* @brief prepares the response of a request for a File in the document root or the bundle
+* @param conn: the connection
+* @param requestFilename: filename from the request, it is normalized in place
+*/
+static void handleFileRequest(struct connection *conn, char *requestFilename) {
+    off_t fileBase;
+    off_t fileSize;
+    int fileFd = openRequestedFile(requestFilename, &fileBase, &fileSize, &conn->listing);
+    if (fileFd == -3) {
+        if (conn->response != NULL && startListing(conn, requestFilename)) {
+            sendHttpResponseHeader(conn, -1);
+        } else {
+            closedir(conn->listing);
+            conn->listing = NULL;
+            conn->keepAlive = 0;
+        }
+    } else if (fileFd == -2) {
+        char *errorMsg = "400 Bad Request";
+        sendHttpResponseError(conn, errorMsg);
+    } else if (fileFd < 0) {
+        char *errorMsg = "404 Not Found";
+        sendHttpResponseError(conn, errorMsg);
+    } else if (conn->response == NULL) {
+        closeFile(fileFd);
+        conn->keepAlive = 0;
+    } else {
+        respondWithFile(conn, fileFd, fileBase, fileSize);
+    }
+}
+
+/**
+* @brief prepares the response with a cached object
+* @details the memory cache is asked first, a small body which is found on disk is copied into it
+* @param conn: the connection, it has a response buffer
+* @param path: normalized path without leading slash
+* @return 1 if the path is cached and else returns 0
+*/
+static int respondFromCache(struct connection *conn, const char *path) {
+    const struct cache_object *object = memory_cache_get(&memoryCache, path);
+    if (object != NULL && object->size > 0) {
+        conn->body = buffer_get(&bufferPools, object->size, &conn->bodyCap);
+    }
+    if (object != NULL && (object->size == 0 || conn->body != NULL)) {
+        if (conn->body != NULL) {
+            memcpy(conn->body, object->data, object->size);
+        }
+        conn->bodyLen = object->size;
+        sendHttpResponseHeader(conn, object->size);
+        return 1;
+    }
+
+    off_t fileBase;
+    off_t fileSize;
+    int fileFd = cache_open(docRootFd, path, &fileBase, &fileSize);
+    if (fileFd < 0) {
+        return 0;
+    }
+    respondWithFile(conn, fileFd, fileBase, fileSize);
+    if (object == NULL && conn->fileFd < 0) {
+        memory_cache_put(&memoryCache, path, conn->body, conn->bodyLen);
+    }
+    return 1;
+}
+
+/**
+* @brief adds a connection to the waiters of an upstream fetch, a connection is added only once
+* @param fill: the fetch
+* @param conn: the connection
+* @return 0 on success and -1 if no memory is left
+*/
+static int addWaiter(struct cache_fill *fill, struct connection *conn) {
+    for (size_t i = 0; i < fill->waiterCount; ++i) {
+        if (fill->waiters[i] == conn) {
+            return 0;
+        }
+    }
+    if (fill->waiterCount == fill->waiterCap) {
+        size_t cap = fill->waiterCap == 0 ? 4 : fill->waiterCap * 2;
+        struct connection **waiters = realloc(fill->waiters, cap * sizeof *waiters);
+        if (waiters == NULL) {
+            return -1;
+        }
+        fill->waiters = waiters;
+        fill->waiterCap = cap;
+    }
+    fill->waiters[fill->waiterCount++] = conn;
+    return 0;
+}
+
+/**
+* @brief reports the progress of an upstream fetch to the server, called in the fetch process
+* @param fill: the fetch
+* @param type: one of the FILL_ reports
+* @param status: status of the upstream response
+* @param size: size of the body or written bytes of the body
+*/
+static void reportFill(const struct cache_fill *fill, uint32_t type, long status, off_t size) {
+    struct fill_message message;
+    memset(&message, 0, sizeof message);
+    message.id = fill->id;
+    message.type = type;
+    message.status = status;
+    message.size = size;
+    // the message is smaller than PIPE_BUF, so the reports of several processes do not mix
+    if (write(fillPipe[1], &message, sizeof message) != sizeof message) {
+        _exit(EXIT_FAILURE);
+    }
+}
+
+/**
+* @brief ends a failed upstream fetch, called in the fetch process
+* @param fill: the fetch
+* @param what: what failed
+*/
+static void failFill(const struct cache_fill *fill, const char *what) {
+    fprintf(stderr, "Error in %s: Upstream fetch of /%s failed: %s\n", program_name, fill->path, what);
+    unlinkat(docRootFd, fill->tmpName, 0);
+    reportFill(fill, FILL_FAILED, 0, 0);
+    _exit(EXIT_FAILURE);
+}
+
+/**
+* @brief connects to the upstream server, called in the fetch process
+* @details a blocking connect to the first address which works, a socket operation which hangs longer than
+* UPSTREAM_TIMEOUT_MS fails
+* @return the socket or -1 on error
+*/
+static int connectUpstream(void) {
+    struct addrinfo hints, *ai;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(upstreamHost, upstreamPort, &hints, &ai) != 0) {
+        return -1;
+    }
+    int sockfd = -1;
+    for (struct addrinfo *rp = ai; rp != NULL && sockfd < 0; rp = rp->ai_next) {
+        sockfd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        if (sockfd < 0) {
+            continue;
+        }
+        struct timeval timeout;
+        timeout.tv_sec = UPSTREAM_TIMEOUT_MS / 1000;
+        timeout.tv_usec = 0;
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout); // also limits connect
+        if (connect(sockfd, rp->ai_addr, rp->ai_addrlen) < 0) {
+            close(sockfd);
+            sockfd = -1;
+        }
+    }
+    freeaddrinfo(ai);
+    return sockfd;
+}
+
+/**
+* @brief writes all bytes to a file
+* @param fd: the file
+* @param data: the bytes
+* @param len: number of bytes
+* @return 0 on success and -1 on error
+*/
+static int writeFile(int fd, const void *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data = (const char *) data + n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * temporary cache file of a fetch process
+ **/
+struct fill_writer {
+    const struct cache_fill *fill;
+    int fd;
+    off_t written; // bytes of the body
+};
+
+/**
+* @brief writes a piece of the body to the cache file and reports it, called by http1_read_body
+* @param context: the fill_writer
+* @param data: the bytes
+* @param len: number of bytes
+* @return 0 on success and -1 if the file cannot be written
+*/
+static int writeFillBody(void *context, const void *data, size_t len) {
+    struct fill_writer *writer = context;
+    if (writeFile(writer->fd, data, len) < 0) {
+        return -1;
+    }
+    writer->written += len;
+    reportFill(writer->fill, FILL_DATA, 200, writer->written);
+    return 0;
+}
+
+static void closeInheritedFds(int keep1, int keep2);
+
+/**
+* @brief fetches a path from the upstream server into the cache directory, runs in the fetch process
+* @details the request and the response are handled by the HTTP/1.1 code of the client. The body of a 200
+* response is written behind the cache header into the temporary cache file and every piece is reported,
+* the complete file is renamed to its cache name before FILL_DONE is reported. A body which ends with the
+* connection is complete in the temporary file when FILL_UNCACHED is reported, it is never renamed. Other
+* responses are only reported with their status. The process never returns.
+* @param fill: the fetch
+*/
+static void runFill(const struct cache_fill *fill) {
+    static char buffer[FILL_BUFFER_LEN];
+    closeInheritedFds(fillPipe[1], docRootFd); // client sockets must not stay open in the fetch process
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGUSR1, SIG_DFL);
+    signal(SIGUSR2, SIG_DFL);
+    signal(SIGHUP, SIG_DFL);
+
+    char *target = malloc(3 * strlen(fill->path) + 1);
+    if (target == NULL) {
+        failFill(fill, "malloc failed");
+    }
+    target[appendUrlEncoded(target, fill->path)] = '\0';
+    int sockfd = connectUpstream();
+    if (sockfd < 0) {
+        failFill(fill, "Could not connect");
+    }
+    BIO *bio = BIO_push(BIO_new(BIO_f_buffer()), BIO_new_socket(sockfd, BIO_CLOSE));
+    struct http1_response response;
+    if (http1_send_request(bio, upstream, target) < 0 || http1_read_status_line(bio, &response) < 0 ||
+        http1_read_header_fields(bio, &response) < 0) {
+        failFill(fill, "Protocol error");
+    }
+    if (response.status != 200) {
+        reportFill(fill, FILL_HEADER, response.status, -1);
+        reportFill(fill, FILL_DONE, response.status, 0);
+        _exit(EXIT_SUCCESS);
+    }
+
+    struct fill_writer writer;
+    char header[CACHE_MAX_PATH_LEN + 32];
+    size_t headerLen = cache_header(header, sizeof header, fill->path);
+    writer.fill = fill;
+    writer.written = 0;
+    writer.fd = openat(docRootFd, fill->tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (writer.fd < 0 || headerLen >= sizeof header || writeFile(writer.fd, header, headerLen) < 0) {
+        failFill(fill, "Cannot write the cache file");
+    }
+    reportFill(fill, FILL_HEADER, 200, response.bodyLen >= 0 ? response.bodyLen : -1);
+    int complete = http1_read_body(bio, response.bodyLen, buffer, sizeof buffer, writeFillBody, &writer);
+    if (complete <= 0) {
+        failFill(fill, complete < 0 ? "Invalid body or cache file not written" : "Connection closed too early");
+    }
+    char name[CACHE_NAME_LEN];
+    cache_name(fill->path, name);
+    if (close(writer.fd) < 0) {
+        failFill(fill, "Cannot write the cache file");
+    }
+    // without Content-Length or chunks a reset of the connection looks like the end of the body
+    if (response.bodyLen == HTTP1_BODY_UNTIL_CLOSE) {
+        reportFill(fill, FILL_UNCACHED, 200, writer.written);
+        _exit(EXIT_SUCCESS);
+    }
+    if (renameat(docRootFd, fill->tmpName, docRootFd, name) < 0) {
+        failFill(fill, "Cannot write the cache file");
+    }
+    reportFill(fill, FILL_DONE, 200, writer.written);
+    _exit(EXIT_SUCCESS);
+}
+
+/**
+* @brief returns the upstream fetch of a path, it is started if no request waits for the path yet
+* @details the fetch runs in a child process, so the blocking HTTP/1.1 code of the client can be used
+* @param path: normalized path without leading slash
+* @return the fetch or NULL if no process could be started
+*/
+static struct cache_fill *startFill(const char *path) {
+    for (struct cache_fill *fill = fills; fill != NULL; fill = fill->next) {
+        if (strcmp(fill->path, path) == 0) {
+            return fill;
+        }
+    }
+    struct cache_fill *fill = calloc(1, sizeof *fill);
+    if (fill == NULL || (fill->path = strdup(path)) == NULL) {
+        free(fill);
+        return NULL;
+    }
+    fill->id = ++nextFillId;
+    fill->size = -1;
+    snprintf(fill->tmpName, sizeof fill->tmpName, ".fill-%ld-%lu", (long) getpid(), (unsigned long) fill->id);
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error in %s: Upstream fetch failed: fork: %s\n", program_name, strerror(errno));
+        free(fill->path);
+        free(fill);
+        return NULL;
+    }
+    if (pid == 0) {
+        runFill(fill);
+    }
+    fill->pid = pid;
+    fill->next = fills;
+    fills = fill;
+    fprintf(stderr, "Cache miss - Fetch /%s from upstream %s\n", path, upstream);
+    return fill;
+}
+
+/**
+* @brief starts to send the temporary cache file of a fetch to a waiting HTTP/1.1 connection
+* @details the connection never sends more than the reported bytes of the body. If the file was renamed
+* already, the connection waits for FILL_DONE.
+* @param conn: the connection, it has a response buffer
+* @param fill: the fetch, its upstream response was 200 with a known size
+*/
+static void streamFill(struct connection *conn, struct cache_fill *fill) {
+    int fileFd = openat(docRootFd, fill->tmpName, O_RDONLY | O_CLOEXEC);
+    if (fileFd < 0) {
+        return;
+    }
+    conn->fileFd = fileFd;
+    conn->fileBase = cache_header(NULL, 0, fill->path);
+    conn->fileOffset = 0;
+    conn->fileSize = fill->size;
+    corkConnection(conn, 1);
+    sendHttpResponseHeader(conn, fill->size);
+}
+
+/**
+* @brief opens the body of a finished fetch for one request
+* @param fill: the fetch
+* @param tmpFd: the temporary file of a body which is not cached or -1 to open the cache file
+* @param fileBase: set to the offset of the body in the returned file descriptor
+* @param fileSize: set to the size of the body
+* @return the file descriptor or -1 on error
+*/
+static int openFillBody(const struct cache_fill *fill, int tmpFd, off_t *fileBase, off_t *fileSize) {
+    if (tmpFd < 0) {
+        return cache_open(docRootFd, fill->path, fileBase, fileSize);
+    }
+    *fileBase = cache_header(NULL, 0, fill->path);
+    *fileSize = fill->available;
+    return fcntl(tmpFd, F_DUPFD_CLOEXEC, 0);
+}
+
+/**
+* @brief ends an upstream fetch and answers the requests which waited for it
+* @details connections which sent the growing file continue or are closed in their next turn if the fetch
+* failed, HTTP/2 streams open the cache file now. A body which is not cached is answered from the temporary
+* file, which is removed afterwards.
+* @param fill: the fetch, it is freed
+* @param result: FILL_DONE, FILL_UNCACHED or FILL_FAILED
+*/
+static void finishFill(struct cache_fill *fill, int result) {
+    struct cache_fill **link = &fills;
+    while (*link != fill) {
+        link = &(*link)->next;
+    }
+    *link = fill->next; // the waiters are not touched by closeConnection any more
+    int tmpFd = result == FILL_UNCACHED ? openat(docRootFd, fill->tmpName, O_RDONLY | O_CLOEXEC) : -1;
+    if (result != FILL_DONE) {
+        unlinkat(docRootFd, fill->tmpName, 0);
+    }
+    int cached = result == FILL_DONE && fill->status == 200;
+    int answered = cached || tmpFd >= 0;
+    char *errorMsg = fill->status == 404 ? "404 Not Found" : "502 Bad Gateway";
+
+    for (size_t i = 0; i < fill->waiterCount; ++i) {
+        struct connection *conn = fill->waiters[i];
+        if (conn->h2 != NULL) {
+            for (int s = 0; s < H2_MAX_STREAMS; ++s) {
+                struct http2_stream *stream = &conn->h2->streams[s];
+                if (stream->id == 0 || stream->fill != fill) {
+                    continue;
+                }
+                stream->fill = NULL;
+                stream->fileFd = answered ? openFillBody(fill, tmpFd, &stream->fileBase, &stream->fileSize) : -1;
+                stream->status = stream->fileFd >= 0 ? "200" : (fill->status == 404 ? "404" : "502");
+                fprintf(stderr, "Get Request from Client - Send Response with Status %s on HTTP/2 stream %lu\n",
+                        stream->status, (unsigned long) stream->id);
+            }
+        } else if (conn->fileFd >= 0) {
+            conn->fill = NULL;
+            // the client sees a short body. Other events of this epoll round may still name the connection,
+            // so it is closed in its own turn.
+            conn->fillFailed = !answered;
+        } else if (tmpFd >= 0) {
+            conn->fill = NULL;
+            off_t fileBase;
+            off_t fileSize;
+            int fileFd = openFillBody(fill, tmpFd, &fileBase, &fileSize);
+            if (fileFd >= 0) {
+                respondWithFile(conn, fileFd, fileBase, fileSize);
+            } else {
+                sendHttpResponseError(conn, errorMsg);
+            }
+        } else {
+            conn->fill = NULL;
+            if (!cached || !respondFromCache(conn, fill->path)) {
+                sendHttpResponseError(conn, errorMsg);
+            }
+        }
+        enqueueConnection(conn);
+    }
+    if (tmpFd >= 0) {
+        close(tmpFd);
+    }
+    free(fill->waiters);
+    free(fill->path);
+    free(fill);
+}
+
+/**
+* @brief handles one progress report of a fetch process
+* @param fill: the fetch
+* @param message: the report
+*/
+static void handleFillMessage(struct cache_fill *fill, const struct fill_message *message) {
+    switch (message->type) {
+        case FILL_HEADER:
+            fill->status = message->status;
+            fill->size = message->size;
+            // small bodies are answered from the complete file, they are fetched in a moment
+            for (size_t i = 0; i < fill->waiterCount && fill->status == 200 && fill->size > SMALL_BODY_LEN; ++i) {
+                struct connection *conn = fill->waiters[i];
+                if (conn->h2 == NULL && conn->fileFd < 0) {
+                    streamFill(conn, fill);
+                    enqueueConnection(conn);
+                }
+            }
+            break;
+        case FILL_DATA:
+            fill->available = message->size;
+            for (size_t i = 0; i < fill->waiterCount; ++i) {
+                if (fill->waiters[i]->h2 == NULL && fill->waiters[i]->fileFd >= 0) {
+                    enqueueConnection(fill->waiters[i]);
+                }
+            }
+            break;
+        case FILL_DONE:
+        case FILL_UNCACHED:
+            fill->available = message->size;
+            finishFill(fill, message->type);
+            break;
+        default:
+            finishFill(fill, FILL_FAILED);
+            break;
+    }
+}
+
+/**
+* @brief reads all progress reports on the fill pipe
+*/
+static void handleFillMessages(void) {
+    struct fill_message messages[64];
+    ssize_t n;
+    // every report was written in one piece, so a read returns whole reports
+    while ((n = read(fillPipe[0], messages, sizeof messages)) > 0) {
+        for (size_t i = 0; i < (size_t) n / sizeof *messages; ++i) {
+            struct cache_fill *fill = fills;
+            while (fill != NULL && fill->id != messages[i].id) {
+                fill = fill->next;
+            }
+            if (fill != NULL) {
+                handleFillMessage(fill, &messages[i]);
+            }
+        }
+    }
+}
+
+/**
+* @brief prepares the response of a proxy
+* @details a cached path is answered at once. A miss waits for the upstream fetch of the path, if the fetch
+* already sends a large body the connection joins it.
+* @param conn: the connection
+* @param requestFilename: filename from the request, it is normalized in place
+*/
+static void handleProxyRequest(struct connection *conn, char *requestFilename) {
+    if (!normalizeRequestPath(requestFilename)) {
+        char *errorMsg = "400 Bad Request";
+        sendHttpResponseError(conn, errorMsg);
+        return;
+    }
+    if (conn->response == NULL) {
+        conn->keepAlive = 0;
+        return;
+    }
+    if (respondFromCache(conn, requestFilename)) {
+        return;
+    }
+    struct cache_fill *fill = startFill(requestFilename);
+    if (fill == NULL || addWaiter(fill, conn) < 0) {
+        char *errorMsg = "502 Bad Gateway";
+        sendHttpResponseError(conn, errorMsg);
+        return;
+    }
+    conn->fill = fill;
+    if (fill->status == 200 && fill->size > SMALL_BODY_LEN) {
+        streamFill(conn, fill);
+    }
+}
+
+static int startHttp2(struct connection *conn, size_t consumed, char *upgradePath,
+                      const unsigned char *upgradeSettings, size_t upgradeSettingsLen);
+static uint32_t http2CheckSettings(const unsigned char *payload, size_t len);
+
+/**
+* @brief prepares the response for a complete request header
+* @details the header is parsed in place in the request buffer
+* @param conn: the connection
+* @param headerLen: length of the request header including the empty line
+* @return 1 if a response was prepared, 2 if the connection was upgraded to HTTP/2 and -1 if no memory is left
+*/
+static int handleRequest(struct connection *conn, size_t headerLen) {
+    char *header = conn->request;
+    header[headerLen - 1] = '\0'; // the last '\n' of the empty line, pipelined bytes follow directly
+
+    char *http2Settings = NULL;
+    // the header is parsed as a string, a NUL byte would hide its line breaks
+    char *firstLineEnd = memchr(header, '\0', headerLen - 1) == NULL ? strstr(header, "\r\n") : NULL;
+    if (firstLineEnd != NULL) {
+        *firstLineEnd = '\0';
+        readRequestHeaderLines(conn, firstLineEnd + 2, &http2Settings);
+    } else {
+        conn->keepAlive = 0;
+    }
+    if (draining) { // the new process serves the next request of the client
+        conn->keepAlive = 0;
+    }
+
+    conn->response = buffer_get(&bufferPools, RESPONSE_HEADER_LEN, &conn->responseCap);
+
+    char *requestFilename;
+    unsigned char settings[256];
+    size_t settingsLen;
+    if (firstLineEnd == NULL) {
+        char *errorMsg = "400 Bad Request";
+        sendHttpResponseError(conn, errorMsg);
+    } else if (checkRequestHeaderAndGetFilename(conn, header, &requestFilename)) {
+        // h2c is only defined for cleartext connections, without valid settings the request stays HTTP/1.1
+        if (http2Settings != NULL && conn->ssl == NULL &&
+            http2_base64url_decode(http2Settings, settings, sizeof settings, &settingsLen) == 0 &&
+            http2CheckSettings(settings, settingsLen) == 0) {
+            buffer_put(&bufferPools, conn->response, conn->responseCap);
+            conn->response = NULL;
+            return startHttp2(conn, headerLen, requestFilename, settings, settingsLen) < 0 ? -1 : 2;
+        }
+
+        if (upstream != NULL) {
+            handleProxyRequest(conn, requestFilename);
+        } else {
+            handleFileRequest(conn, requestFilename);
+        }
+    }
+
+    // keep pipelined bytes of the next request
+    conn->requestLen -= headerLen;
+    memmove(conn->request, conn->request + headerLen, conn->requestLen);
+
+    conn->state = CONN_WRITE_RESPONSE;
+    timer_arm(&timers, &conn->timer, WRITE_TIMEOUT_MS);
+    return 1;
+}
+
+/**
+* @brief checks if a complete request header was received and prepares the response
+* @param conn: the connection
+* @return 1 if a response was prepared, 2 if the connection was switched to HTTP/2, 0 if more bytes are
+* needed and -1 if no memory is left
+*/
+static int parseRequest(struct connection *conn) {
+    size_t prefaceLen = conn->requestLen < HTTP2_PREFACE_LEN ? conn->requestLen : HTTP2_PREFACE_LEN;
+    if (memcmp(conn->request, HTTP2_PREFACE, prefaceLen) == 0) { // HTTP/2 with prior knowledge
+        if (prefaceLen < HTTP2_PREFACE_LEN) {
+            return 0;
+        }
+        return startHttp2(conn, 0, NULL, NULL, 0) < 0 ? -1 : 2;
+    }
+
+    char *end = NULL;
+    for (size_t i = 3; i < conn->requestLen; ++i) {
+        if (memcmp(conn->request + i - 3, "\r\n\r\n", 4) == 0) {
+            end = conn->request + i + 1;
+            break;
+        }
+    }
+
+    if (end == NULL) {
+        if (conn->requestLen == conn->requestCap - 1) { // header does not fit in the buffer
+            conn->response = buffer_get(&bufferPools, RESPONSE_HEADER_LEN, &conn->responseCap);
+            char *errorMsg = "400 Bad Request";
+            sendHttpResponseError(conn, errorMsg);
+            conn->requestLen = 0;
+            conn->state = CONN_WRITE_RESPONSE;
+            timer_arm(&timers, &conn->timer, WRITE_TIMEOUT_MS);
+            return 1;
+        }
+        return 0;
+    }
+
+    return handleRequest(conn, end - conn->request);
+}
+
+/**
+* @brief send the response header and the body buffer
+* @details sends the rest of the response header and a small body with one sendmsg
+* @param conn: the connection
+* @return 1 if both were sent completely, 0 if the socket is full or the connection is throttled and -1 on
+* error
+*/
+static int sendResponseBuffers(struct connection *conn) {
+    while (conn->responseSent < conn->responseLen + conn->bodyLen) {
+        if (sendAllowance(conn) <= 0) {
+            return 0;
+        }
+        struct iovec iov[2];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof msg);
+        msg.msg_iov = iov;
+
+        if (conn->responseSent < conn->responseLen) {
+            iov[msg.msg_iovlen].iov_base = conn->response + conn->responseSent;
+            iov[msg.msg_iovlen].iov_len = conn->responseLen - conn->responseSent;
+            msg.msg_iovlen++;
+        }
+        size_t bodySent = conn->responseSent > conn->responseLen ? conn->responseSent - conn->responseLen : 0;
+        if (bodySent < conn->bodyLen) {
+            iov[msg.msg_iovlen].iov_base = conn->body + bodySent;
+            iov[msg.msg_iovlen].iov_len = conn->bodyLen - bodySent;
+            msg.msg_iovlen++;
+        }
+
+        // more data follows with sendfile, do not push a segment with only the header
+        int more = conn->fileFd >= 0 || conn->listing != NULL;
+        ssize_t n = connectionSend(conn, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        conn->responseSent += n;
+        timer_arm(&timers, &conn->timer, WRITE_TIMEOUT_MS);
+    }
+    return 1;
+}
+
+/**
+* @brief send the response
+* @details sends the rest of the response header and a small body with one sendmsg and then the requested
+* File with sendfile. With TLS in user space the File is read into the body buffer piece by piece instead.
+* A directory listing is produced chunk by chunk whenever the body buffer was sent. At most the allowance
+* of the connection is sent with one sendfile. A File which an upstream fetch still writes is sent up to
+* the reported bytes.
+* @param conn: the connection
+* @return 1 if the response was sent completely, 0 if the socket is full, the connection is throttled or
+* waits for the upstream fetch and -1 on error
+*/
+static int sendResponse(struct connection *conn) {
+    for (;;) {
+        int sent = sendResponseBuffers(conn);
+        if (sent <= 0) {
+            return sent;
+        }
+        if (conn->listing != NULL) {
+            produceListingChunk(conn);
+            continue;
+        }
+        if (conn->ssl == NULL || conn->kernelTls || conn->fileFd < 0 || conn->fileOffset >= conn->fileSize) {
+            break;
+        }
+        if (conn->body == NULL) {
+            conn->body = buffer_get(&bufferPools, SMALL_BODY_LEN, &conn->bodyCap);
+            if (conn->body == NULL) {
+                return -1;
+            }
+        }
+        off_t left = (conn->fill != NULL ? conn->fill->available : conn->fileSize) - conn->fileOffset;
+        if (left <= 0) {
+            return 0;
+        }
+        ssize_t n = pread(conn->fileFd, conn->body, left < (off_t) conn->bodyCap ? left : (off_t) conn->bodyCap,
+                          conn->fileBase + conn->fileOffset);
+        if (n <= 0) { // read error or the file was truncated
+            return -1;
+        }
+        conn->fileOffset += n;
+        conn->bodyLen = n;
+        conn->responseSent = conn->responseLen;
+    }
+
+    while (conn->fileFd >= 0 && conn->fileOffset < conn->fileSize) {
+        off_t left = (conn->fill != NULL ? conn->fill->available : conn->fileSize) - conn->fileOffset;
+        if (left <= 0) {
+            return 0;
+        }
+        long allowance = sendAllowance(conn);
+        if (allowance <= 0) {
+            return 0;
+        }
+        off_t position = conn->fileBase + conn->fileOffset;
+        ssize_t n = sendfile(conn->fd, conn->fileFd, &position, left < allowance ? left : allowance);
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        if (n == 0) { // file was truncated
+            return -1;
+        }
+        conn->fileOffset += n;
+        chargeConnection(conn, n);
+        timer_arm(&timers, &conn->timer, WRITE_TIMEOUT_MS);
+    }
+    return 1;
+}
+
+/**
+* @brief returns space for a frame at the end of the HTTP/2 output buffer
+* @param session: the HTTP/2 session
+* @param len: number of bytes which are needed
+* @return pointer to the space or NULL if the buffer is full
+*/
+static unsigned char *http2Reserve(struct http2_session *session, size_t len) {
+    if (session->outCap - session->outLen < len && session->outSent > 0) { // drop the sent bytes
+        session->outLen -= session->outSent;
+        memmove(session->out, session->out + session->outSent, session->outLen);
+        session->outSent = 0;
+    }
+    if (session->outCap - session->outLen < len) {
+        return NULL;
+    }
+    return session->out + session->outLen;
+}
+
+/**
+* @brief appends a frame to the HTTP/2 output buffer
+* @param session: the HTTP/2 session
+* @param type: type of the frame
+* @param flags: flags of the frame
+* @param streamId: stream of the frame
+* @param payload: payload of the frame
+* @param len: length of the payload
+*/
+static void http2QueueFrame(struct http2_session *session, uint8_t type, uint8_t flags, uint32_t streamId,
+                            const unsigned char *payload, size_t len) {
+    unsigned char *out = http2Reserve(session, HTTP2_FRAME_HEADER_LEN + len);
+    if (out == NULL) { // input is only processed while H2_CONTROL_RESERVE bytes are free
+        return;
+    }
+    http2_write_frame_header(out, len, type, flags, streamId);
+    memcpy(out + HTTP2_FRAME_HEADER_LEN, payload, len);
+    session->outLen += HTTP2_FRAME_HEADER_LEN + len;
+}
+
+/**
+* @brief appends a frame with a 32 bit payload, like RST_STREAM or WINDOW_UPDATE
+* @param session: the HTTP/2 session
+* @param type: type of the frame
+* @param streamId: stream of the frame
+* @param value: the payload
+*/
+static void http2QueueValue(struct http2_session *session, uint8_t type, uint32_t streamId, uint32_t value) {
+    unsigned char payload[4];
+    http2_put32(payload, value);
+    http2QueueFrame(session, type, 0, streamId, payload, sizeof payload);
+}
+
+/**
+* @brief appends a GOAWAY frame, no new streams are accepted afterwards
+* @param session: the HTTP/2 session
+* @param errorCode: reason for the GOAWAY
+*/
+static void http2QueueGoaway(struct http2_session *session, uint32_t errorCode) {
+    unsigned char payload[8];
+    http2_put32(payload, session->lastStreamId);
+    http2_put32(payload + 4, errorCode);
+    http2QueueFrame(session, HTTP2_GOAWAY, 0, 0, payload, sizeof payload);
+    session->goaway = 1;
+}
+
+/**
+* @brief looks up an open stream
+* @param session: the HTTP/2 session
+* @param streamId: id of the stream
+* @return the stream or NULL if the stream is not open
+*/
+static struct http2_stream *http2FindStream(struct http2_session *session, uint32_t streamId) {
+    for (int i = 0; i < H2_MAX_STREAMS; ++i) {
+        if (session->streams[i].id == streamId) {
+            return &session->streams[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+* @brief closes a stream and frees its slot
+* @param session: the HTTP/2 session
+* @param stream: the stream
+*/
+static void http2CloseStream(struct http2_session *session, struct http2_stream *stream) {
+    if (stream->fileFd >= 0) {
+        closeFile(stream->fileFd);
+        stream->fileFd = -1;
+    }
+    if (stream->listing != NULL) {
+        closedir(stream->listing);
+        stream->listing = NULL;
+    }
+    if (stream->body != NULL) {
+        buffer_put(&bufferPools, stream->body, stream->bodyCap);
+        stream->body = NULL;
+    }
+    stream->fill = NULL; // the connection stays a waiter of the fetch, which finds no stream then
+    stream->id = 0;
+    session->activeStreams--;
+}
+
+/**
+* @brief opens a stream for a request and looks up the requested File
+* @param session: the HTTP/2 session
+* @param streamId: id of the stream
+* @param method: request method or NULL if it is missing
+* @param path: requested path or NULL if it is missing
+*/
+static void http2OpenStream(struct http2_session *session, uint32_t streamId, char *method, char *path) {
+    struct http2_stream *stream = http2FindStream(session, 0);
+    if (stream == NULL) {
+        http2QueueValue(session, HTTP2_RST_STREAM, streamId, HTTP2_REFUSED_STREAM);
+        return;
+    }
+    stream->id = streamId;
+    stream->window = session->peerInitialWindow;
+    stream->fileFd = -1;
+    stream->fileBase = 0;
+    stream->fileOffset = 0;
+    stream->fileSize = 0;
+    stream->headersSent = 0;
+    stream->fill = NULL;
+    stream->listing = NULL;
+    stream->body = NULL;
+    stream->bodyLen = 0;
+    stream->bodySent = 0;
+    session->activeStreams++;
+
+    if (method == NULL || path == NULL) {
+        stream->status = "400";
+    } else if (strcmp(method, "GET") != 0) {
+        stream->status = "501";
+    } else {
+        stream->fileFd = openRequestedFile(path, &stream->fileBase, &stream->fileSize, &stream->listing);
+        if (stream->fileFd == -3) { // the listing needs no chunks, its pieces are sent as DATA frames
+            stream->fileFd = -1;
+            stream->body = buffer_get(&bufferPools, SMALL_BODY_LEN, &stream->bodyCap);
+            if (stream->body == NULL) {
+                closedir(stream->listing);
+                stream->listing = NULL;
+                stream->status = "503";
+            } else {
+                stream->bodyLen = writeListingHead(stream->body, path);
+                stream->status = "200";
+            }
+            fprintf(stderr, "Get Request from Client - Send Response with Status %s on HTTP/2 stream %lu\n",
+                    stream->status, (unsigned long) streamId);
+            return;
+        }
+        if (stream->fileFd == -1 && upstream != NULL) { // a miss is answered when the whole file is cached
+            stream->fill = startFill(path);
+            if (stream->fill != NULL && addWaiter(stream->fill, session->conn) == 0) {
+                stream->status = NULL;
+                return;
+            }
+            stream->fill = NULL;
+        }
+        stream->status = stream->fileFd >= 0 ? "200" : (stream->fileFd == -2 ? "400" : (upstream != NULL ? "502" : "404"));
+        if (stream->fileFd < 0) {
+            stream->fileFd = -1;
+        }
+    }
+    fprintf(stderr, "Get Request from Client - Send Response with Status %s on HTTP/2 stream %lu\n",
+            stream->status, (unsigned long) streamId);
+}
+
+/**
+ * pseudo header fields of a HTTP/2 request
+ **/
+struct http2_request {
+    char method[16];
+    char path[MAX_CHAR_LEN];
+    int hasMethod;
+    int hasPath;
+};
+
+/**
+* @brief collects the pseudo header fields of a request, called by the HPACK decoder
+* @param context: the http2_request
+* @param name: name of the header field
+* @param nameLen: length of the name
+* @param value: value of the header field
+* @param valueLen: length of the value
+*/
+static void http2RequestHeader(void *context, const char *name, size_t nameLen, const char *value, size_t valueLen) {
+    struct http2_request *request = context;
+    if (nameLen == strlen(":method") && memcmp(name, ":method", nameLen) == 0 &&
+        valueLen < sizeof(request->method)) {
+        memcpy(request->method, value, valueLen);
+        request->method[valueLen] = '\0';
+        request->hasMethod = 1;
+    } else if (nameLen == strlen(":path") && memcmp(name, ":path", nameLen) == 0 &&
+               valueLen < sizeof(request->path)) {
+        memcpy(request->path, value, valueLen);
+        request->path[valueLen] = '\0';
+        request->hasPath = 1;
+    }
+}
+
+/**
+* @brief decodes a complete header block and opens the stream of the request
+* @param session: the HTTP/2 session
+* @param streamId: stream of the header block
+* @param block: the header block
+* @param len: length of the header block
+* @return 0 on success or a HTTP/2 error code
+*/
+static uint32_t http2HandleHeaderBlock(struct http2_session *session, uint32_t streamId,
+                                       const unsigned char *block, size_t len) {
+    struct http2_request request;
+    request.hasMethod = 0;
+    request.hasPath = 0;
+    if (hpack_decode(&session->decoder, block, len, http2RequestHeader, &request) < 0) {
+        return HTTP2_COMPRESSION_ERROR;
+    }
+    if (streamId <= session->lastStreamId) { // trailers of an open stream
+        return 0;
+    }
+    session->lastStreamId = streamId;
+    if (!session->goaway) {
+        http2OpenStream(session, streamId, request.hasMethod ? request.method : NULL,
+                        request.hasPath ? request.path : NULL);
+    }
+    return 0;
+}
+
+/**
+* @brief checks the SETTINGS of the client
+* @param payload: payload of the SETTINGS frame or the decoded HTTP2-Settings header
+* @param len: length of the payload
+* @return 0 if the settings are valid or a HTTP/2 error code
+*/
+static uint32_t http2CheckSettings(const unsigned char *payload, size_t len) {
+    if (len % 6 != 0) {
+        return HTTP2_FRAME_SIZE_ERROR;
+    }
+    for (size_t i = 0; i < len; i += 6) {
+        uint16_t id = (payload[i] << 8) | payload[i + 1];
+        uint32_t value = http2_get32(payload + i + 2);
+        if (id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE && value > HTTP2_MAX_WINDOW) {
+            return HTTP2_FLOW_CONTROL_ERROR;
+        }
+        if (id == HTTP2_SETTINGS_MAX_FRAME_SIZE && (value < HTTP2_DEFAULT_FRAME_SIZE || value > 0xffffff)) {
+            return HTTP2_PROTOCOL_ERROR;
+        }
+    }
+    return 0;
+}
+
+/**
+* @brief applies the SETTINGS of the client
+* @param session: the HTTP/2 session
+* @param payload: payload of the SETTINGS frame
+* @param len: length of the payload
+* @return 0 on success or a HTTP/2 error code
+*/
+static uint32_t http2ApplySettings(struct http2_session *session, const unsigned char *payload, size_t len) {
+    uint32_t error = http2CheckSettings(payload, len);
+    if (error != 0) {
+        return error;
+    }
+    for (size_t i = 0; i < len; i += 6) {
+        uint16_t id = (payload[i] << 8) | payload[i + 1];
+        uint32_t value = http2_get32(payload + i + 2);
+        if (id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE) {
+            int overflow = 0;
+            for (int s = 0; s < H2_MAX_STREAMS; ++s) { // the change applies to all open streams
+                session->streams[s].window += (long) value - session->peerInitialWindow;
+                overflow |= session->streams[s].id != 0 && session->streams[s].window > HTTP2_MAX_WINDOW;
+            }
+            session->peerInitialWindow = value;
+            if (overflow) {
+                return HTTP2_FLOW_CONTROL_ERROR;
+            }
+        } else if (id == HTTP2_SETTINGS_MAX_FRAME_SIZE) {
+            session->peerMaxFrameSize = value;
+        }
+    }
+    return 0;
+}
+
+/**
+* @brief processes one complete frame of the client
+* @param session: the HTTP/2 session
+* @param frame: header of the frame
+* @param payload: payload of the frame
+* @return 0 on success or a HTTP/2 error code
+*/
+static uint32_t http2ProcessFrame(struct http2_session *session, struct http2_frame *frame,
+                                  const unsigned char *payload) {
+    if (session->headerStream != 0 &&
+        (frame->type != HTTP2_CONTINUATION || frame->streamId != session->headerStream)) {
+        return HTTP2_PROTOCOL_ERROR; // a header block must not be interrupted
+    }
+
+    switch (frame->type) {
+        case HTTP2_HEADERS: {
+            size_t len;
+            if (frame->streamId == 0 || frame->streamId % 2 == 0 ||
+                http2_strip_padding(frame, &payload, &len) < 0) {
+                return HTTP2_PROTOCOL_ERROR;
+            }
+            if (frame->flags & HTTP2_FLAG_END_HEADERS) {
+                return http2HandleHeaderBlock(session, frame->streamId, payload, len);
+            }
+            // collect the header block until the last CONTINUATION frame
+            session->headerBlock = (unsigned char *) buffer_get(&bufferPools, H2_MAX_HEADER_BLOCK,
+                                                                &session->headerBlockCap);
+            if (session->headerBlock == NULL || len > session->headerBlockCap) {
+                return HTTP2_INTERNAL_ERROR;
+            }
+            memcpy(session->headerBlock, payload, len);
+            session->headerBlockLen = len;
+            session->headerStream = frame->streamId;
+            return 0;
+        }
+        case HTTP2_CONTINUATION: {
+            if (session->headerStream == 0) {
+                return HTTP2_PROTOCOL_ERROR;
+            }
+            if (frame->length > session->headerBlockCap - session->headerBlockLen) {
+                return HTTP2_INTERNAL_ERROR;
+            }
+            memcpy(session->headerBlock + session->headerBlockLen, payload, frame->length);
+            session->headerBlockLen += frame->length;
+            if (!(frame->flags & HTTP2_FLAG_END_HEADERS)) {
+                return 0;
+            }
+            uint32_t error = http2HandleHeaderBlock(session, session->headerStream, session->headerBlock,
+                                                    session->headerBlockLen);
+            buffer_put(&bufferPools, (char *) session->headerBlock, session->headerBlockCap);
+            session->headerBlock = NULL;
+            session->headerStream = 0;
+            return error;
+        }
+        case HTTP2_SETTINGS: {
+            if (frame->streamId != 0) {
+                return HTTP2_PROTOCOL_ERROR;
+            }
+            if (frame->flags & HTTP2_FLAG_ACK) {
+                return 0;
+            }
+            uint32_t error = http2ApplySettings(session, payload, frame->length);
+            if (error == 0) {
+                http2QueueFrame(session, HTTP2_SETTINGS, HTTP2_FLAG_ACK, 0, NULL, 0);
+            }
+            return error;
+        }
+        case HTTP2_PING:
+            if (frame->length != 8) {
+                return HTTP2_FRAME_SIZE_ERROR;
+            }
+            if (!(frame->flags & HTTP2_FLAG_ACK)) {
+                http2QueueFrame(session, HTTP2_PING, HTTP2_FLAG_ACK, 0, payload, 8);
+            }
+            return 0;
+        case HTTP2_WINDOW_UPDATE: {
+            if (frame->length != 4) {
+                return HTTP2_FRAME_SIZE_ERROR;
+            }
+            long increment = http2_get32(payload) & 0x7fffffff;
+            if (frame->streamId == 0) {
+                session->window += increment;
+                return increment == 0 ? HTTP2_PROTOCOL_ERROR :
+                       session->window > HTTP2_MAX_WINDOW ? HTTP2_FLOW_CONTROL_ERROR : 0;
+            }
+            struct http2_stream *stream = http2FindStream(session, frame->streamId);
+            if (stream != NULL) {
+                stream->window += increment;
+            }
+            // errors of a stream only reset the stream
+            if (increment == 0 || (stream != NULL && stream->window > HTTP2_MAX_WINDOW)) {
+                http2QueueValue(session, HTTP2_RST_STREAM, frame->streamId,
+                                increment == 0 ? HTTP2_PROTOCOL_ERROR : HTTP2_FLOW_CONTROL_ERROR);
+                if (stream != NULL) {
+                    http2CloseStream(session, stream);
+                }
+            }
+            return 0;
+        }
+        case HTTP2_RST_STREAM: {
+            if (frame->streamId == 0) {
+                return HTTP2_PROTOCOL_ERROR;
+            }
+            if (frame->length != 4) {
+                return HTTP2_FRAME_SIZE_ERROR;
+            }
+            struct http2_stream *stream = http2FindStream(session, frame->streamId);
+            if (stream != NULL) {
+                http2CloseStream(session, stream);
+            }
+            return 0;
+        }
+        case HTTP2_GOAWAY:
+            session->goaway = 1; // finish the open streams, then close
+            return 0;
+        case HTTP2_PUSH_PROMISE:
+            return HTTP2_PROTOCOL_ERROR;
+        default: // PRIORITY and unknown frames are ignored
+            return 0;
+    }
+}
 
+/**
+* @brief processes all complete frames in the HTTP/2 input buffer
+* @details DATA frames are not needed for GET requests, their payload is dropped while it arrives and
+* given back to the flow control window of the client
+* @param session: the HTTP/2 session
+* @return the number of processed bytes or -1 on a connection error
+*/
+static long http2ProcessInput(struct http2_session *session) {
+    size_t pos = 0;
 
-#define BINARY_BUFFER_LEN 1024 * 1024
-#define MAX_CHAR_LEN 2048
+    if (!session->prefaceReceived) {
+        if (session->inLen < HTTP2_PREFACE_LEN) {
+            return 0;
+        }
+        if (memcmp(session->in, HTTP2_PREFACE, HTTP2_PREFACE_LEN) != 0) {
+            return -1;
+        }
+        session->prefaceReceived = 1;
+        pos = HTTP2_PREFACE_LEN;
+    }
 
-static char *program_name;
-static int isListening = 1;
+    while (pos < session->inLen && session->outCap - (session->outLen - session->outSent) >= H2_CONTROL_RESERVE) {
+        if (session->discard > 0) {
+            size_t n = session->inLen - pos < session->discard ? session->inLen - pos : session->discard;
+            session->discard -= n;
+            pos += n;
+            continue;
+        }
+        if (session->inLen - pos < HTTP2_FRAME_HEADER_LEN) {
+            break;
+        }
+
+        struct http2_frame frame;
+        http2_read_frame_header(session->in + pos, &frame);
+        uint32_t error = 0;
+        if (frame.length > HTTP2_DEFAULT_FRAME_SIZE) { // the SETTINGS_MAX_FRAME_SIZE of the server
+            error = HTTP2_FRAME_SIZE_ERROR;
+        } else if (frame.type == HTTP2_DATA) {
+            if (frame.streamId == 0) {
+                error = HTTP2_PROTOCOL_ERROR;
+            } else if (frame.length > 0) {
+                http2QueueValue(session, HTTP2_WINDOW_UPDATE, 0, frame.length);
+                if (http2FindStream(session, frame.streamId) != NULL) {
+                    http2QueueValue(session, HTTP2_WINDOW_UPDATE, frame.streamId, frame.length);
+                }
+            }
+            session->discard = frame.length;
+            pos += HTTP2_FRAME_HEADER_LEN;
+        } else if (HTTP2_FRAME_HEADER_LEN + frame.length > session->inCap) {
+            error = HTTP2_FRAME_SIZE_ERROR;
+        } else if (session->inLen - pos < HTTP2_FRAME_HEADER_LEN + frame.length) {
+            break;
+        } else {
+            error = http2ProcessFrame(session, &frame, session->in + pos + HTTP2_FRAME_HEADER_LEN);
+            pos += HTTP2_FRAME_HEADER_LEN + frame.length;
+        }
+
+        if (error != 0) {
+            http2QueueGoaway(session, error);
+            return -1;
+        }
+    }
+
+    session->inLen -= pos;
+    memmove(session->in, session->in + pos, session->inLen);
+    return pos;
+}
 
 /**
-* @brief checks if Directory exists
-* @details checks if Directory exists with open the directory and close it
-* @param dirName: Name of the Directory
-* @return 1 if the Directory exists and else returns 0
-**/
-static int checkDirExists(char *dirName) {
-    DIR *dir = opendir(dirName);
-    if (dir) {
-        /* Directory exists. */
-        closedir(dir);
+* @brief writes the next frame of a stream into the HTTP/2 output buffer
+* @param session: the HTTP/2 session
+* @param stream: the stream
+* @return the number of written bytes, 0 if the stream is blocked by flow control or the buffer is full
+*/
+static size_t http2ProduceStream(struct http2_session *session, struct http2_stream *stream) {
+    if (stream->status == NULL) { // waits for the upstream fetch
+        return 0;
+    }
+    if (!stream->headersSent) {
+        unsigned char block[192];
+        size_t len = hpack_encode(block, sizeof block, ":status", stream->status);
+        char date[64];
+        setCurrentDate(date, sizeof(date));
+        len += hpack_encode(block + len, sizeof block - len, "date", date);
+        if (stream->body != NULL) {
+            len += hpack_encode(block + len, sizeof block - len, "content-type", "text/html; charset=utf-8");
+        } else if (stream->fileFd >= 0) {
+            char contentLength[32];
+            snprintf(contentLength, sizeof contentLength, "%lld", (long long) stream->fileSize);
+            len += hpack_encode(block + len, sizeof block - len, "content-length", contentLength);
+        }
+        if (http2Reserve(session, HTTP2_FRAME_HEADER_LEN + len) == NULL) {
+            return 0;
+        }
+        int endStream = stream->body == NULL && (stream->fileFd < 0 || stream->fileSize == 0);
+        http2QueueFrame(session, HTTP2_HEADERS, HTTP2_FLAG_END_HEADERS | (endStream ? HTTP2_FLAG_END_STREAM : 0),
+                        stream->id, block, len);
+        stream->headersSent = 1;
+        if (endStream) {
+            http2CloseStream(session, stream);
+        }
+        return HTTP2_FRAME_HEADER_LEN + len;
+    }
+
+    if (stream->body != NULL && stream->bodySent == stream->bodyLen) { // the next entries of the listing
+        stream->bodyLen = writeListingEntries(&stream->listing, stream->body, stream->bodyCap);
+        stream->bodySent = 0;
+    }
+    long len = stream->body != NULL ? (long) (stream->bodyLen - stream->bodySent)
+                                    : stream->fileSize - stream->fileOffset;
+    if (len > stream->window) {
+        len = stream->window;
+    }
+    if (len > session->window) {
+        len = session->window;
+    }
+    if (len > (long) session->peerMaxFrameSize) {
+        len = session->peerMaxFrameSize;
+    }
+    unsigned char *out = http2Reserve(session, HTTP2_FRAME_HEADER_LEN + 1);
+    if (len <= 0 || out == NULL) {
+        return 0;
+    }
+    if (len > (long) (session->outCap - session->outLen - HTTP2_FRAME_HEADER_LEN)) {
+        len = session->outCap - session->outLen - HTTP2_FRAME_HEADER_LEN;
+    }
+
+    ssize_t n;
+    if (stream->body != NULL) {
+        memcpy(out + HTTP2_FRAME_HEADER_LEN, stream->body + stream->bodySent, len);
+        n = len;
+    } else if (stream->fileFd == bundle.fd) {
+        memcpy(out + HTTP2_FRAME_HEADER_LEN, bundle.map + stream->fileBase + stream->fileOffset, len);
+        n = len;
+    } else {
+        n = pread(stream->fileFd, out + HTTP2_FRAME_HEADER_LEN, len, stream->fileBase + stream->fileOffset);
+    }
+    if (n <= 0) { // read error or the file was truncated
+        http2QueueValue(session, HTTP2_RST_STREAM, stream->id, HTTP2_INTERNAL_ERROR);
+        http2CloseStream(session, stream);
         return 1;
+    }
+    int endStream;
+    if (stream->body != NULL) {
+        stream->bodySent += n;
+        endStream = stream->listing == NULL && stream->bodySent == stream->bodyLen;
     } else {
-        return 0;
+        stream->fileOffset += n;
+        endStream = stream->fileOffset == stream->fileSize;
+    }
+    stream->window -= n;
+    session->window -= n;
+    http2_write_frame_header(out, n, HTTP2_DATA, endStream ? HTTP2_FLAG_END_STREAM : 0, stream->id);
+    session->outLen += HTTP2_FRAME_HEADER_LEN + n;
+    if (endStream) {
+        http2CloseStream(session, stream);
     }
+    return HTTP2_FRAME_HEADER_LEN + n;
 }
 
 /**
-* @brief checks if the Port is valid
-* @details a vaild Port must be between 1 and 65535
-* @param strPort: Port as a String
-**/
-static void checkValidPort(char *strPort) {
-    char *ptr;
-    long port;
-    port = strtol(strPort, &ptr, 10);
-    if (port < 1 || port > 65535) {
-        fprintf(stderr, "Error in %s:Port must be between 1 and 65535 \n", program_name);
-        exit(EXIT_FAILURE);
+* @brief fills the HTTP/2 output buffer with frames of the open streams
+* @details the streams take turns frame by frame, so a large File does not delay the other streams
+* @param session: the HTTP/2 session
+* @return the number of written bytes
+*/
+static size_t http2ProduceOutput(struct http2_session *session) {
+    size_t produced = 0;
+    size_t round;
+    if (!session->prefaceReceived) { // after an upgrade, answer stream 1 once the client speaks HTTP/2
+        return 0;
     }
+    do {
+        round = 0;
+        for (int i = 0; i < H2_MAX_STREAMS && session->activeStreams > 0; ++i) {
+            struct http2_stream *stream = &session->streams[(session->nextStream + i) % H2_MAX_STREAMS];
+            if (stream->id != 0) {
+                round += http2ProduceStream(session, stream);
+            }
+        }
+        session->nextStream = (session->nextStream + 1) % H2_MAX_STREAMS;
+        produced += round;
+    } while (round > 0);
+    return produced;
 }
 
+/**
+* @brief sends the HTTP/2 output buffer
+* @param conn: the connection
+* @return 1 if everything was sent, 0 if the socket is full or the connection is throttled and -1 on error
+*/
+static int http2Flush(struct connection *conn) {
+    struct http2_session *session = conn->h2;
+    while (session->outSent < session->outLen) {
+        if (sendAllowance(conn) <= 0) {
+            return 0;
+        }
+        struct iovec iov;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof msg);
+        iov.iov_base = session->out + session->outSent;
+        iov.iov_len = session->outLen - session->outSent;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t n = connectionSend(conn, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        session->outSent += n;
+    }
+    session->outSent = 0;
+    session->outLen = 0;
+    return 1;
+}
 
 /**
-* @brief checks if options are correct
-* @details checks if options are correct and if each option ist only one time given
-* @param p: option p
-* @param i: option i
-**/
-static void checkOptions(int p, int i) {
-    if (p > 1) {
-        fprintf(stderr, "Error in %s: Too many Ports\n", program_name);
-        exit(EXIT_FAILURE);
+* @brief switches a connection to HTTP/2
+* @details with prior knowledge the received bytes start with the connection preface, after an upgrade the
+* request becomes stream 1 and the "101 Switching Protocols" response is sent before the server preface
+* @param conn: the connection
+* @param consumed: bytes of the request buffer which belong to the HTTP/1.1 upgrade request
+* @param upgradePath: requested path of the upgrade request or NULL with prior knowledge
+* @param upgradeSettings: decoded and checked HTTP2-Settings header of the upgrade request
+* @param upgradeSettingsLen: length of the settings
+* @return 1 on success and -1 if no memory is left
+*/
+static int startHttp2(struct connection *conn, size_t consumed, char *upgradePath,
+                      const unsigned char *upgradeSettings, size_t upgradeSettingsLen) {
+    struct http2_session *session = pool_get(&sessionPool);
+    if (session == NULL) {
+        return -1;
+    }
+    conn->h2 = session;
+    session->conn = conn;
+    session->in = (unsigned char *) buffer_get(&bufferPools, H2_BUFFER_LEN, &session->inCap);
+    session->out = (unsigned char *) buffer_get(&bufferPools, H2_BUFFER_LEN, &session->outCap);
+    session->inLen = 0;
+    session->outLen = 0;
+    session->outSent = 0;
+    session->headerBlock = NULL;
+    session->headerBlockLen = 0;
+    session->headerBlockCap = 0;
+    session->headerStream = 0;
+    session->discard = 0;
+    session->prefaceReceived = 0;
+    session->window = HTTP2_DEFAULT_WINDOW;
+    session->peerInitialWindow = HTTP2_DEFAULT_WINDOW;
+    session->peerMaxFrameSize = HTTP2_DEFAULT_FRAME_SIZE;
+    session->lastStreamId = 0;
+    session->goaway = 0;
+    session->activeStreams = 0;
+    session->nextStream = 0;
+    for (int i = 0; i < H2_MAX_STREAMS; ++i) {
+        session->streams[i].id = 0;
+        session->streams[i].fileFd = -1;
+        session->streams[i].window = 0;
+        session->streams[i].fill = NULL;
+        session->streams[i].listing = NULL;
+        session->streams[i].body = NULL;
+    }
+    hpack_table_init(&session->decoder);
+    if (session->in == NULL || session->out == NULL) {
+        return -1;
     }
 
-    if (i > 1) {
-        fprintf(stderr, "Error in %s: Too many index \n", program_name);
-        exit(EXIT_FAILURE);
+    if (upgradePath != NULL) {
+        static const char switching[] = "HTTP/1.1 101 Switching Protocols\r\n"
+                                        "Connection: Upgrade\r\n"
+                                        "Upgrade: h2c\r\n\r\n";
+        memcpy(session->out, switching, strlen(switching));
+        session->outLen = strlen(switching);
+
+        http2ApplySettings(session, upgradeSettings, upgradeSettingsLen);
+        session->lastStreamId = 1;
+        http2OpenStream(session, 1, "GET", upgradePath);
     }
-}
 
+    unsigned char settings[12];
+    size_t settingsLen = http2_write_setting(settings, HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, H2_MAX_STREAMS);
+    settingsLen += http2_write_setting(settings + settingsLen, HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE,
+                                       H2_MAX_HEADER_BLOCK);
+    http2QueueFrame(session, HTTP2_SETTINGS, 0, 0, settings, settingsLen);
 
-/**
-* @brief set the current Date
-* @details set the current Date and Time
-* @param date: variable in which the Date will be saved
-* @param errorMsg: errorMsg which will be send
-**/
-static void setCurrentDate(char *date) {
-    time_t now = time(&now);
-    struct tm *tm = gmtime(&now);
-    strftime(date, MAX_CHAR_LEN, "%a, %d %b %y %H:%M:%S %Z", tm);
+    memcpy(session->in, conn->request + consumed, conn->requestLen - consumed);
+    session->inLen = conn->requestLen - consumed;
+    conn->requestLen = 0;
+    releaseBuffers(conn);
+    return 1;
 }
 
 /**
-* @brief sends a Http Response Error
-* @details sends a Http Response Error with a specific Error message
-* @param sockfile: file for the communication between server and client
-* @param errorMsg: errorMsg which will be send
-**/
-static void sendHttpResponseError(FILE *sockfile, char *errorMsg) {
-    fprintf(stderr, "%s", errorMsg);
-    char responseError[100] = {0};
-    sprintf(responseError, "HTTP/1.1 %s\r\n"
-                           "Connection: close\r\n\r\n", errorMsg);
-
-    fputs(responseError, sockfile);
-    fflush(sockfile); // send all buffered data
+* @brief  communication with a HTTP/2 client
+* @details  reads frames, answers them and sends the responses of all open streams until the socket would block
+* @param conn: the connection
+*/
+static void communicateHttp2(struct connection *conn) {
+    struct http2_session *session = conn->h2;
+    int readable = 1;
 
-}
+    for (;;) {
+        int flushed = http2Flush(conn);
+        if (flushed < 0) {
+            closeConnection(conn);
+            return;
+        }
 
-/**
-* @brief sends a Http Response Header
-* @details sends a Http Response Header with a specific filesize
-* @param sockfile: file for the communication between server and client
-* @param fileSize: size from the response File
-**/
-static void sendHttpResponseHeader(FILE *sockfile, int fileSize) {
-    fprintf(stderr, "200 OK");
-    char date[MAX_CHAR_LEN];
-    setCurrentDate(date);
-    char responseHeader[1000] = {0};
+        ssize_t n = 0;
+        if (readable && session->inLen < session->inCap) {
+            n = connectionRecv(conn, session->in + session->inLen, session->inCap - session->inLen);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                closeConnection(conn);
+                return;
+            }
+            if (n < 0) {
+                readable = 0;
+                n = 0;
+            }
+            session->inLen += n;
+        }
 
-    sprintf(responseHeader, "HTTP/1.1 200 OK\r\n"
-                            "Date: %s\r\n"
-                            "Content-Lenght: %d\r\n"
-                            "Connection: close\r\n\r\n", date, fileSize);
+        long processed = http2ProcessInput(session);
+        if (processed < 0) { // try to tell the client why the connection is closed
+            http2Flush(conn);
+            closeConnection(conn);
+            return;
+        }
+        if (draining && !session->goaway) { // the client opens new streams on a new connection
+            http2QueueGoaway(session, HTTP2_NO_ERROR);
+        }
+        size_t produced = http2ProduceOutput(session);
 
-    fputs(responseHeader, sockfile);
-    fflush(sockfile); // send all buffered data
+        if (session->goaway && session->activeStreams == 0 && session->outSent == session->outLen) {
+            closeConnection(conn);
+            return;
+        }
+        if (n == 0 && processed == 0 && produced == 0 && (flushed == 0 || session->outSent == session->outLen)) {
+            break;
+        }
+    }
 
+    int pending = session->outSent < session->outLen;
+    watchConnection(conn, EPOLLIN | (pending && !conn->throttled ? EPOLLOUT : 0));
+    if (pending && conn->throttled) {
+        scheduleConnection(conn);
+    }
+    timer_arm(&timers, &conn->timer, session->activeStreams > 0 ? WRITE_TIMEOUT_MS : KEEPALIVE_TIMEOUT_MS);
 }
 
 /**
-* @brief checks the fist line of the Http Request Header
-* @details checks the fist line of the Http Request Header if the request method and the protocol is correct
-* @param sockfile: file for the communication between server and client
-* @param header_line: first line of the header
-* @param requestFilename: filename from the requested File
-* @return 1 if the Header is correct  and 0 if the Header is not correct and a error message was send
-**/
-static int checkRequestHeaderAndGetFilename(FILE *sockfile, char *header_line, char *requestFilename) {
-    char *requestMethod;
-    requestMethod = strtok(header_line, " ");
-    char *filename;
-    filename = strtok(NULL, " ");
-
-    strcat(requestFilename, filename);
-	
-    if (strcmp(requestMethod, "GET") != 0) {
-        char *errorMsg = "501 Not implemented";
-        sendHttpResponseError(sockfile, errorMsg);
-        return 0;
+* @brief  continues the TLS handshake
+* @details after the handshake kernel TLS is used if OpenSSL could install the keys in the kernel, with ALPN
+* "h2" the client starts with the HTTP/2 connection preface like with prior knowledge
+* @param conn: the connection
+* @return 1 if the handshake is done, 0 if the socket would block and -1 on error
+*/
+static int continueHandshake(struct connection *conn) {
+    static int kernelTlsWarned = 0;
+    ERR_clear_error();
+    int n = SSL_do_handshake(conn->ssl);
+    if (n == 1) {
+        conn->kernelTls = tls_kernel_send(conn->ssl);
+        if (!conn->kernelTls && (SSL_CTX_get_options(tlsContext) & SSL_OP_ENABLE_KTLS) && !kernelTlsWarned) {
+            kernelTlsWarned = 1;
+            fprintf(stderr, "Kernel TLS is not available - Encrypt in user space\n");
+        }
+        return 1;
     }
-
-    char *protocol;
-    protocol = strtok(NULL, " ");
-
-    if (strcmp(protocol, "HTTP/1.1\r\n") != 0) {
-        //getErrorMessage(400, errorMsg);
-        char *errorMsg = "400 Bad Request";
-        sendHttpResponseError(sockfile, errorMsg);
-        return 0;
+    switch (SSL_get_error(conn->ssl, n)) {
+        case SSL_ERROR_WANT_READ:
+            watchConnection(conn, EPOLLIN);
+            return 0;
+        case SSL_ERROR_WANT_WRITE:
+            watchConnection(conn, EPOLLOUT);
+            return 0;
+        default:
+            return -1;
     }
-
-    return 1;
 }
 
 /**
-* @brief reads the Header from the request
-* @details reads the Header from the request and get the Filename from the response File
-* @param sockfile: file for the communication between server and client
-* @param requestFilename: filename from the requested File
-* @return 1 if the Header is correct  and 0 if the Header is not correct and a error message was send
+* @brief  communication with the client
+* @details  reads requests and writes responses until the socket would block or the turn of the connection
+* is used up
+* @param conn: the connection
+* @param events: events reported by epoll
 */
-static int readRequestHeaderAndGetFilename(FILE *sockfile, char *requestFilename) {
-    char header_line[MAX_CHAR_LEN];
-    char first_header_line[MAX_CHAR_LEN] = "";
+static void communicateWithClient(struct connection *conn, uint32_t events) {
+    if ((events & (EPOLLERR | EPOLLHUP)) || conn->fillFailed) {
+        closeConnection(conn);
+        return;
+    }
+    // a new turn, unless the connection already waits for one
+    if (!conn->queued && !timer_armed(&conn->shapeTimer)) {
+        conn->deficit = conn->deficit < 0 ? conn->deficit + SEND_QUANTUM : SEND_QUANTUM;
+    }
+    conn->throttled = 0;
 
-    //read html status line
-    fgets(header_line, sizeof(header_line), sockfile);
-    strcat(first_header_line, header_line);
+    if (conn->ssl != NULL && !SSL_is_init_finished(conn->ssl)) {
+        int handshake = continueHandshake(conn);
+        if (handshake < 0) {
+            closeConnection(conn);
+            return;
+        }
+        if (handshake == 0) {
+            return;
+        }
+    }
 
-    //read header line by line until last header line "\r\n"
-    while (strcmp(header_line, "\r\n") != 0) {
-        fgets(header_line, sizeof(header_line), sockfile);
+    if (conn->h2 != NULL) {
+        communicateHttp2(conn);
+        return;
     }
 
-    return checkRequestHeaderAndGetFilename(sockfile, first_header_line, requestFilename);
-}
+    for (;;) {
+        if (conn->state == CONN_READ_HEADER) {
+            int parsed = conn->request != NULL ? parseRequest(conn) : 0;
+            if (parsed < 0) {
+                closeConnection(conn);
+                return;
+            }
+            if (parsed == 2) {
+                communicateHttp2(conn);
+                return;
+            }
+            if (parsed == 0) {
+                if (conn->request == NULL) {
+                    conn->request = buffer_get(&bufferPools, REQUEST_BUFFER_LEN, &conn->requestCap);
+                    if (conn->request == NULL) {
+                        closeConnection(conn);
+                        return;
+                    }
+                }
+                ssize_t n = connectionRecv(conn, conn->request + conn->requestLen,
+                                           conn->requestCap - 1 - conn->requestLen);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    closeConnection(conn);
+                    return;
+                }
+                if (n < 0) {
+                    releaseBuffers(conn);
+                    watchConnection(conn, EPOLLIN);
+                    return;
+                }
+                if (conn->requestLen == 0) { // first bytes of a request, the whole header has to follow in time
+                    timer_arm(&timers, &conn->timer, HEADER_TIMEOUT_MS);
+                }
+                conn->requestLen += n;
+                continue;
+            }
+        }
+
+        if (conn->fill != NULL && conn->fileFd < 0) { // the upstream fetch has not answered yet
+            watchConnection(conn, 0);
+            return;
+        }
+        int sent = sendResponse(conn);
+        if (sent < 0) {
+            closeConnection(conn);
+            return;
+        }
+        if (sent == 0 && conn->fill != NULL && conn->fileOffset >= conn->fill->available) {
+            watchConnection(conn, 0); // the next report of the fetch queues the connection
+            return;
+        }
+        if (sent == 0 && conn->throttled) {
+            watchConnection(conn, 0);
+            scheduleConnection(conn);
+            return;
+        }
+        if (sent == 0) {
+            watchConnection(conn, EPOLLOUT);
+            return;
+        }
 
+        if (conn->fileFd >= 0) {
+            corkConnection(conn, 0);
+            closeFile(conn->fileFd);
+            conn->fileFd = -1;
+        }
+        if (conn->fill != NULL) { // the whole body was sent before the fetch reported its end
+            forgetWaiter(conn);
+            conn->fill = NULL;
+        }
+        if (!conn->keepAlive) {
+            closeConnection(conn);
+            return;
+        }
+        conn->state = CONN_READ_HEADER;
+        releaseBuffers(conn);
+        timer_arm(&timers, &conn->timer, conn->requestLen > 0 ? HEADER_TIMEOUT_MS : KEEPALIVE_TIMEOUT_MS);
+    }
+}
 
 /**
-* @brief This function returns the size of a file.
-* @details This function returns the size of a file.
-* @param file
-* @return returns the size of a file.
+* @brief  the address of a client as IPv6 address
+* @param peer: address from accept
+* @param address: set to the IPv6 address, IPv4 addresses are mapped to ::ffff:a.b.c.d
 */
-static unsigned long fsize(char *file) {
-    FILE *f = fopen(file, "r");
-    fseek(f, 0, SEEK_END);
-    unsigned long len = (unsigned long) ftell(f);
-    fclose(f);
-    return len;
+static void clientAddress(const struct sockaddr_storage *peer, unsigned char address[16]) {
+    if (peer->ss_family == AF_INET6) {
+        memcpy(address, &((const struct sockaddr_in6 *) peer)->sin6_addr, 16);
+        return;
+    }
+    memset(address, 0, 10);
+    address[10] = 0xff;
+    address[11] = 0xff;
+    memcpy(address + 12, &((const struct sockaddr_in *) peer)->sin_addr, 4);
 }
 
-
 /**
-* @brief get the path of the requested File
-* @details get the path of the requested File in the root directory
-* @param requestedFile: File which will be send
-* @param DocRoot: directory of the server
-* @param index: name of the index file
-* @param requestedFilepath: path of the requested File in the root directory
+* @brief  runs one round of the deficit round robin
+* @details every connection which waits in the run queue gets one turn, connections which are queued again
+* in this round wait for the next round
 */
-static void getRequestedFilepath(char *requestedFilepath, char *DocRoot, char *requestedFilename, char *index) {
-    strcat(requestedFilepath, DocRoot);
-    strcat(requestedFilepath, "/");
-    if (strcmp(requestedFilename, "/") == 0) { //send index file
-        strcat(requestedFilepath, index);
-    } else {
-        strcat(requestedFilepath, requestedFilename);
+static void runQueuedConnections(void) {
+    struct connection *last = runQueueTail;
+    while (runQueueHead != NULL) {
+        struct connection *conn = runQueueHead;
+        dequeueConnection(conn);
+        communicateWithClient(conn, EPOLLOUT); // may close and free the connection
+        if (conn == last) {
+            break;
+        }
     }
 }
 
 /**
-* @brief send requested File
-* @details send requested File to the sockedfile
-* @param requestedFile: File which will be send
-* @param sockfile: file for the communication between server and client
+* @brief  accepts all pending connections
+* @param sockfd: listening socket
 */
-static void sendFile(FILE *sockfile, FILE *requestedFile) {
-    uint8_t binary_buffer[BINARY_BUFFER_LEN];
-    while (!feof(requestedFile)) {
-        ssize_t n = fread(binary_buffer, sizeof(uint8_t), BINARY_BUFFER_LEN, requestedFile);
-        fwrite(binary_buffer, sizeof(uint8_t), n, sockfile);
+static void acceptConnections(int sockfd) {
+    for (;;) {
+        struct sockaddr_storage peer;
+        socklen_t peerLen = sizeof peer;
+        int fd_client = accept(sockfd, (struct sockaddr *) &peer, &peerLen);
+        if (fd_client < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                fprintf(stderr, "Error in %s: accept failed: %s\n", program_name, strerror(errno));
+            }
+            return;
+        }
+        fcntl(fd_client, F_SETFL, fcntl(fd_client, F_GETFL) | O_NONBLOCK);
+        // responses are coalesced or corked, so Nagle would only delay the last segment of each response
+        int nodelay = 1;
+        setsockopt(fd_client, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof nodelay);
+
+        struct connection *conn = pool_get(&connectionPool);
+        if (conn == NULL) {
+            close(fd_client);
+            continue;
+        }
+        conn->fd = fd_client;
+        conn->state = CONN_READ_HEADER;
+        conn->keepAlive = 0;
+        conn->request = NULL;
+        conn->requestLen = 0;
+        conn->requestCap = 0;
+        conn->response = NULL;
+        conn->responseLen = 0;
+        conn->responseCap = 0;
+        conn->responseSent = 0;
+        conn->body = NULL;
+        conn->bodyLen = 0;
+        conn->bodyCap = 0;
+        conn->fileFd = -1;
+        conn->fileBase = 0;
+        conn->fileOffset = 0;
+        conn->fileSize = 0;
+        conn->listing = NULL;
+        conn->h2 = NULL;
+        conn->ssl = NULL;
+        conn->kernelTls = 0;
+        conn->events = EPOLLIN;
+        conn->deficit = 0;
+        conn->throttled = 0;
+        conn->queued = 0;
+        conn->client = NULL;
+        conn->fill = NULL;
+        conn->fillFailed = 0;
+        timer_init(&conn->shapeTimer, shapeTimeout);
+        token_bucket_init(&conn->bucket, connectionRate, connectionRate != 0 ? shaper_now() : 0);
+        timer_init(&conn->timer, connectionTimeout);
+        timer_arm(&timers, &conn->timer, HEADER_TIMEOUT_MS); // also the deadline of the TLS handshake
+        if (tlsContext != NULL) {
+            conn->ssl = SSL_new(tlsContext);
+            if (conn->ssl == NULL || SSL_set_fd(conn->ssl, fd_client) != 1) {
+                closeConnection(conn);
+                continue;
+            }
+            SSL_set_accept_state(conn->ssl);
+        }
+        if (clients.rate != 0) {
+            unsigned char address[16];
+            clientAddress(&peer, address);
+            conn->client = client_table_get(&clients, address, shaper_now());
+            if (conn->client == NULL) {
+                closeConnection(conn);
+                continue;
+            }
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof ev);
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd_client, &ev) < 0) {
+            closeConnection(conn);
+        }
     }
 }
 
 /**
 * @brief  starts the server
-* @details  starts the server and build a connection
+* @details  starts the server and build a connection, the socket listens on IPv6 and IPv4 (as mapped
+* addresses) and falls back to IPv4 only if the kernel has no IPv6
 * @param port: port from the Server
 */
 static int getConnection(char * port) {
     struct addrinfo hints, *ai;
     memset(&hints,0, sizeof(hints));
-    hints.ai_family = AF_INET;
+    hints.ai_family = AF_INET6;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_flags = AI_PASSIVE;
 
     int s = getaddrinfo(NULL, port, &hints, &ai);
-    if (s != 0) {
-        freeaddrinfo(ai);
-        fprintf(stderr,
-                "ERROR in %s: getaddrinfo failed: %s", program_name,
-                gai_strerror(s)
-        );
-        exit(EXIT_FAILURE);
+    int sockfd = s == 0 ? socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol) : -1;
+    if (sockfd >= 0) {
+        int v6only = 0; // the default depends on net.ipv6.bindv6only
+        setsockopt(sockfd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof v6only);
+    } else {
+        if (s == 0) {
+            freeaddrinfo(ai);
+        }
+        hints.ai_family = AF_INET;
+        s = getaddrinfo(NULL, port, &hints, &ai);
+        if (s != 0) {
+            fprintf(stderr,
+                    "ERROR in %s: getaddrinfo failed: %s", program_name,
+                    gai_strerror(s)
+            );
+            exit(EXIT_FAILURE);
+        }
+        sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
     }
-
-    int sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
     if (sockfd < 0) {
         freeaddrinfo(ai);
         fprintf(stderr,
@@ -284,53 +3035,197 @@ static int getConnection(char * port) {
         exit(EXIT_FAILURE);
     }
 
-    if (listen(sockfd,10) < 0) {
+    // wake up accept only when the request has arrived, the header timeout starts with the data
+    int deferAccept = HEADER_TIMEOUT_MS / 1000;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferAccept, sizeof deferAccept);
+    // let clients which know a cookie send the request in the SYN
+    int fastOpen = FASTOPEN_QUEUE_LEN;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN, &fastOpen, sizeof fastOpen);
+
+    if (listen(sockfd, SOMAXCONN) < 0) {
         freeaddrinfo(ai);
         fprintf(stderr,"ERROR in %s: listen Failed", program_name);
         exit(EXIT_FAILURE);
     }
     freeaddrinfo(ai);
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK);
     return sockfd;
 }
 
 /**
-* @brief  communication with the client
-* @details  communication with the client and send teh requested File
-* @param fd_client: value of the client
-* @param docRoot: directory of the server
-* @param index: name of the index file
-*/
-static void communicateWithClient(int fd_client, char *docRoot, char *index) {
-    FILE *sockfile = fdopen(fd_client, "r+");
-    char requestFilename[MAX_CHAR_LEN] = "";
+ * @brief  handle all signals
+ * @param signal: sinal which will be handled
+ */
+static void handle_signal(int signal) {
+    if (signal == SIGUSR1) {
+        printStats = 1;
+    } else if (signal == SIGHUP || signal == SIGUSR2) {
+        reloadRequested = 1;
+    } else if (signal == SIGCHLD) {
+        childExited = 1;
+    } else {
+        isListening = 0;
+    }
+}
+
+/**
+ * @brief  print the statistics of all pools
+ **/
+static void printPoolStats(void) {
+    pool_print_stats(&connectionPool, stderr);
+    pool_print_stats(&sessionPool, stderr);
+    buffer_pools_print_stats(&bufferPools, stderr);
+    if (clients.rate != 0) {
+        pool_print_stats(&clients.pool, stderr);
+    }
+    if (upstream != NULL) {
+        memory_cache_print_stats(&memoryCache, stderr);
+    }
+}
+
+/**
+ * @brief  closes all file descriptors except stdin, stdout, stderr and the given ones
+ * @details called in the new process before exec, so it does not keep connections of the old process open
+ * @param keep1: descriptor which stays open
+ * @param keep2: descriptor which stays open
+ **/
+static void closeInheritedFds(int keep1, int keep2) {
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == NULL) {
+        long max = sysconf(_SC_OPEN_MAX);
+        for (int fd = 3; fd < max; ++fd) {
+            if (fd != keep1 && fd != keep2) {
+                close(fd);
+            }
+        }
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int fd = atoi(entry->d_name);
+        if (fd > 2 && fd != keep1 && fd != keep2 && fd != dirfd(dir)) {
+            close(fd);
+        }
+    }
+    closedir(dir);
+}
 
-    int headerValid = readRequestHeaderAndGetFilename(sockfile, requestFilename);
+/**
+ * @brief  starts a new server process which takes over the listening socket
+ * @details the new process runs the binary which is installed now with the same arguments, until it is
+ * ready this process keeps accepting connections
+ * @param sockfd: listening socket
+ * @param argv: arguments of this process
+ **/
+static void startReload(int sockfd, char *argv[]) {
+    if (reloadPipe >= 0 || draining) {
+        fprintf(stderr, "Reload is already in progress\n");
+        return;
+    }
+    int ready[2];
+    if (pipe(ready) < 0) {
+        fprintf(stderr, "Error in %s: Reload failed: pipe: %s\n", program_name, strerror(errno));
+        return;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error in %s: Reload failed: fork: %s\n", program_name, strerror(errno));
+        close(ready[0]);
+        close(ready[1]);
+        return;
+    }
+    if (pid == 0) {
+        char value[16];
+        closeInheritedFds(sockfd, ready[1]);
+        snprintf(value, sizeof value, "%d", sockfd);
+        setenv(LISTEN_FD_ENV, value, 1);
+        snprintf(value, sizeof value, "%d", ready[1]);
+        setenv(READY_FD_ENV, value, 1);
+        execvp(argv[0], argv);
+        fprintf(stderr, "Error in %s: Reload failed: exec: %s\n", program_name, strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
 
-    if (headerValid) {
+    close(ready[1]);
+    reloadPipe = ready[0];
+    reloadPid = pid;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.ptr = &reloadPipe; // marks the readiness pipe
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, reloadPipe, &ev);
+    fprintf(stderr, "Reload - Started new Server with pid %ld\n", (long) pid);
+}
 
-        char requestedFilepath[MAX_CHAR_LEN] = "";
-        getRequestedFilepath(requestedFilepath, docRoot, requestFilename, index);
+/**
+ * @brief  called when the drain deadline expired
+ * @param timer: the drain timer
+ **/
+static void drainTimeout(struct timer *timer) {
+    fprintf(stderr, "Reload - Drain deadline expired, close %lu connections\n", connectionPool.inUse);
+    isListening = 0;
+}
 
-        FILE *requestedFile = fopen(requestedFilepath, "r");
+/**
+ * @brief  handles the readiness pipe of the new process
+ * @details if the new process is ready this process stops accepting connections and starts draining,
+ * if it exited before, this process keeps serving
+ * @param sockfd: listening socket
+ **/
+static void finishReload(int sockfd) {
+    char ready;
+    ssize_t n = read(reloadPipe, &ready, 1);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    close(reloadPipe); // also removes the pipe from the epoll set
+    reloadPipe = -1;
+    if (n != 1) {
+        waitpid(reloadPid, NULL, WNOHANG);
+        fprintf(stderr, "Error in %s: Reload failed, new Server did not start\n", program_name);
+        return;
+    }
 
-        if (requestedFile == NULL) {
-            char *errorMsg = "404 Not Found";
-            sendHttpResponseError(sockfile, errorMsg);
-        } else {
-            int fileSize = fsize(requestedFilepath);
-            sendHttpResponseHeader(sockfile, fileSize);
-            sendFile(sockfile, requestedFile);
+    // the socket stays open in the new process, pending connections in the backlog are accepted there
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, sockfd, NULL);
+    close(sockfd);
+    draining = 1;
+    timer_init(&drainTimer, drainTimeout);
+    timer_arm(&timers, &drainTimer, DRAIN_TIMEOUT_MS);
+    fprintf(stderr, "Reload - New Server is ready, drain %lu connections\n", connectionPool.inUse);
+}
+
+/**
+ * @brief  reaps the exited fetch processes, a fetch whose process died without reporting its end failed
+ **/
+static void reapFills(void) {
+    handleFillMessages(); // the reports which the processes wrote before they exited
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        for (struct cache_fill *fill = fills; fill != NULL; fill = fill->next) {
+            if (fill->pid == pid) {
+                fprintf(stderr, "Error in %s: Upstream fetch of /%s ended without result\n", program_name, fill->path);
+                finishFill(fill, FILL_FAILED);
+                break;
+            }
         }
     }
-    fclose(sockfile);
 }
 
 /**
- * @brief  handle all signals
- * @param signal: sinal which will be handled
- */
-static void handle_signal(int signal) {
-    isListening = 0;
+ * @brief  tells the process which started this one that connections are accepted now
+ **/
+static void reportReady(void) {
+    char *readyFd = getenv(READY_FD_ENV);
+    if (readyFd == NULL) {
+        return;
+    }
+    int fd = atoi(readyFd);
+    if (write(fd, "1", 1) != 1) {
+        fprintf(stderr, "Error in %s: could not report readiness\n", program_name);
+    }
+    close(fd);
+    unsetenv(READY_FD_ENV);
 }
 
 /**
@@ -338,16 +3233,28 @@ static void handle_signal(int signal) {
  **/
 static void setup_signal_handlers(void) {
     //initial signal
-    struct sigaction sa_sigint, sa_sigterm;
+    struct sigaction sa_sigint, sa_sigterm, sa_sigusr1, sa_sigreload, sa_sigpipe, sa_sigchld;
     memset(&sa_sigint, 0, sizeof sa_sigint);
     memset(&sa_sigterm, 0, sizeof sa_sigterm);
+    memset(&sa_sigusr1, 0, sizeof sa_sigusr1);
+    memset(&sa_sigreload, 0, sizeof sa_sigreload);
+    memset(&sa_sigpipe, 0, sizeof sa_sigpipe);
+    memset(&sa_sigchld, 0, sizeof sa_sigchld);
 
     //function for signal
     sa_sigint.sa_handler = handle_signal;
     sa_sigterm.sa_handler = handle_signal;
+    sa_sigusr1.sa_handler = handle_signal;
+    sa_sigreload.sa_handler = handle_signal;
+    sa_sigpipe.sa_handler = SIG_IGN; // a client which closed its socket must not kill the server
+    sa_sigchld.sa_handler = handle_signal;
+    sa_sigchld.sa_flags = SA_NOCLDSTOP;
 
     //signal error
-    if (sigaction(SIGINT, &sa_sigint, NULL) != 0 || sigaction(SIGTERM, &sa_sigterm, NULL) != 0) {
+    if (sigaction(SIGINT, &sa_sigint, NULL) != 0 || sigaction(SIGTERM, &sa_sigterm, NULL) != 0 ||
+        sigaction(SIGUSR1, &sa_sigusr1, NULL) != 0 || sigaction(SIGHUP, &sa_sigreload, NULL) != 0 ||
+        sigaction(SIGUSR2, &sa_sigreload, NULL) != 0 || sigaction(SIGPIPE, &sa_sigpipe, NULL) != 0 ||
+        sigaction(SIGCHLD, &sa_sigchld, NULL) != 0) {
         fprintf(stderr, "Error in %s : signal error\n", program_name);
         exit(EXIT_FAILURE);
     }
@@ -355,10 +3262,14 @@ static void setup_signal_handlers(void) {
 
 /**
  * Program entry point.
- * @brief The program starts here. This function represent the Server. 
+ * @brief The program starts here. This function represent the Server.
  * @details he server waits for connections from clients and transmits the requested files.
  *Option -p can be used to specify the port on which the server shall listen for incoming connections.If this option is not used the port defaults to 8080 (port 80 requires root privileges).
  * Option -i is used to specify the index filename, i.e. the file which the server shall attempt to transmit if the request path is a directory. The default index filename is index.html.
+ * Options -c and -k give the certificate and the private key for HTTPS, option -s encrypts in user space
+ * even if the kernel supports TLS.
+ * Option -u makes the server a caching proxy of the upstream server HOST:PORT, DOC_ROOT is the cache
+ * directory then.
  * @param argc The argument counter.
  * @param argv The argument vector.
  * @return Returns <code>EXIT_SUCCESS</code> on success, <code>EXIT_FAILURE</code> otherwise.
@@ -372,9 +3283,20 @@ int main(int argc, char *argv[]) {
     // --------------------------------getOpt---Begin----------------------------------
     int opt_p = 0;
     int opt_i = 0;
+    int opt_c = 0;
+    int opt_k = 0;
+    int opt_b = 0;
+    int opt_r = 0;
+    int opt_R = 0;
+    int opt_u = 0;
+    long clientRate = 0;
+    int kernelTls = 1;
+    char *bundleFile = NULL;
+    char *certFile = NULL;
+    char *keyFile = NULL;
     int opt;
 
-    while ((opt = getopt(argc, argv, "p:i:")) != -1) {
+    while ((opt = getopt(argc, argv, "p:i:c:k:sb:r:R:u:")) != -1) {
         switch (opt) {
             case 'p': //option p is given
                 opt_p += 1;
@@ -384,51 +3306,181 @@ int main(int argc, char *argv[]) {
                 opt_i += 1;
                 index = optarg;
                 break;
+            case 'c': //option c is given
+                opt_c += 1;
+                certFile = optarg;
+                break;
+            case 'k': //option k is given
+                opt_k += 1;
+                keyFile = optarg;
+                break;
+            case 's': //option s is given
+                kernelTls = 0;
+                break;
+            case 'b': //option b is given
+                opt_b += 1;
+                bundleFile = optarg;
+                break;
+            case 'r': //option r is given
+                opt_r += 1;
+                connectionRate = parseRate(optarg);
+                break;
+            case 'R': //option R is given
+                opt_R += 1;
+                clientRate = parseRate(optarg);
+                break;
+            case 'u': //option u is given
+                opt_u += 1;
+                parseUpstream(optarg);
+                break;
             default: /* '?' */ //somiting wrong ist given
-                fprintf(stderr, "Usage: %s [-p PORT] [-i INDEX] DOC_ROOT\n", program_name);
+                fprintf(stderr, "Usage: %s [-p PORT] [-i INDEX] [-c CERT -k KEY [-s]] [-r RATE] [-R RATE] DOC_ROOT\n"
+                                "       %s [-p PORT] [-c CERT -k KEY [-s]] [-r RATE] [-R RATE] -b BUNDLE\n"
+                                "       %s [-p PORT] [-c CERT -k KEY [-s]] [-r RATE] [-R RATE] -u HOST:PORT CACHE_DIR\n",
+                        program_name, program_name, program_name);
                 return EXIT_FAILURE;
         }
     }
 
-    if (optind + 1 != argc) { //unspecified options or too many arguments
+    if (optind + (bundleFile == NULL ? 1 : 0) != argc) { //unspecified options or too many arguments
         fprintf(stderr,
-                "Error %s: unspecified options or too many arguments \nUsage: %s [-p PORT] [-i INDEX] DOC_ROOT\n",
-                program_name, program_name);
+                "Error %s: unspecified options or too many arguments \nUsage: %s [-p PORT] [-i INDEX] [-c CERT -k KEY [-s]] [-r RATE] [-R RATE] DOC_ROOT\n"
+                "       %s [-p PORT] [-c CERT -k KEY [-s]] [-r RATE] [-R RATE] -b BUNDLE\n"
+                "       %s [-p PORT] [-c CERT -k KEY [-s]] [-r RATE] [-R RATE] -u HOST:PORT CACHE_DIR\n",
+                program_name, program_name, program_name, program_name);
         return EXIT_FAILURE;
     }
 
-    checkOptions(opt_p, opt_i);
+    checkOptions(opt_p, opt_i, opt_c, opt_k, opt_b, opt_r, opt_R, opt_u);
     checkValidPort(port);
 
 
     //------------------check dir----------------
-    char *docRoot = argv[optind];
-    if (!checkDirExists(docRoot)) {
-        fprintf(stderr, "Error in %s: Directory does not exist\n", program_name);
-        exit(EXIT_FAILURE);
+    indexFile = index;
+    docRootFd = -1;
+    if (bundleFile != NULL) {
+        if (bundle_open(&bundle, bundleFile) < 0) {
+            fprintf(stderr, "Error in %s: Cannot map bundle %s: %s\n", program_name, bundleFile,
+                    errno == EINVAL ? "no valid bundle" : strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "Serving %llu files and directories from bundle %s\n",
+                (unsigned long long) bundle.header->entryCount, bundleFile);
+    } else {
+        docRoot = argv[optind];
+        docRootFd = open(docRoot, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (docRootFd < 0) {
+            fprintf(stderr, "Error in %s: Directory does not exist\n", program_name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (certFile != NULL) {
+        tlsContext = tls_server_context(certFile, keyFile, kernelTls);
+        if (tlsContext == NULL) {
+            tls_print_errors(program_name);
+            fprintf(stderr, "Error in %s: Could not load certificate %s and key %s\n", program_name, certFile, keyFile);
+            exit(EXIT_FAILURE);
+        }
     }
 
     //------------connect to client---------------------
 
-    int sockfd = getConnection(port);
+    int sockfd;
+    char *listenFd = getenv(LISTEN_FD_ENV);
+    if (listenFd != NULL) { // started by a reload, the old process still accepts on the same socket
+        sockfd = atoi(listenFd);
+        unsetenv(LISTEN_FD_ENV);
+    } else {
+        sockfd = getConnection(port);
+    }
+
+    epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        fprintf(stderr, "Error in %s: epoll_create failed\n", program_name);
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event listenEvent;
+    memset(&listenEvent, 0, sizeof listenEvent);
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = NULL; // NULL marks the listening socket
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, sockfd, &listenEvent);
+    timer_wheel_init(&timers, timer_now());
+    pool_init(&connectionPool, "connection", sizeof(struct connection));
+    pool_init(&sessionPool, "http2 session", sizeof(struct http2_session));
+    buffer_pools_init(&bufferPools);
+    client_table_init(&clients, clientRate);
+    if (upstream != NULL) {
+        if (pipe(fillPipe) < 0) {
+            fprintf(stderr, "Error in %s: pipe failed\n", program_name);
+            exit(EXIT_FAILURE);
+        }
+        fcntl(fillPipe[0], F_SETFL, fcntl(fillPipe[0], F_GETFL) | O_NONBLOCK);
+        fcntl(fillPipe[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fillPipe[1], F_SETFD, FD_CLOEXEC);
+        struct epoll_event fillEvent;
+        memset(&fillEvent, 0, sizeof fillEvent);
+        fillEvent.events = EPOLLIN;
+        fillEvent.data.ptr = fillPipe; // marks the fill pipe
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fillPipe[0], &fillEvent);
+        memory_cache_init(&memoryCache, CACHE_MEMORY_LEN);
+        fprintf(stderr, "Caching upstream %s in %s\n", upstream, docRoot);
+    }
 
-    fprintf(stderr, "Listening on http://localhost:%s ...\n", port);
+    fprintf(stderr, "Listening on %s://localhost:%s ...\n", tlsContext != NULL ? "https" : "http", port);
+    reportReady();
 
+    struct epoll_event events[MAX_EVENTS];
     while (isListening) {
-        int fd_client = accept(sockfd, NULL, NULL);
-        if (fd_client < 0) {
-            close(fd_client);
+        // connections in the run queue continue right after the events which are ready now
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, runQueueHead != NULL ? 0 : timer_wheel_timeout(&timers));
+        if (n < 0 && errno != EINTR) {
+            fprintf(stderr, "Error in %s: epoll_wait failed\n", program_name);
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == NULL) {
+                acceptConnections(sockfd);
+            } else if (events[i].data.ptr == &reloadPipe) {
+                finishReload(sockfd);
+            } else if (events[i].data.ptr == fillPipe) {
+                handleFillMessages();
+            } else {
+                communicateWithClient(events[i].data.ptr, events[i].events);
+            }
+        }
+        if (childExited && upstream != NULL) {
+            childExited = 0;
+            reapFills();
+        }
+        timer_wheel_advance(&timers, timer_now());
+        runQueuedConnections();
+        if (printStats) {
+            printStats = 0;
+            printPoolStats();
+        }
+        if (reloadRequested) {
+            reloadRequested = 0;
+            startReload(sockfd, argv);
+        }
+        if (draining && connectionPool.inUse == 0) {
             break;
         }
-        fprintf(stderr, "Get Request from Client - Send Response with Status ");
-        communicateWithClient(fd_client, docRoot, index);
-        fprintf(stderr, " - Closed Connection to Client\n");
-        close(fd_client);
     }
 
 
     //cleanup
-    close(sockfd);
+    close(epollFd);
+    if (bundle.fd >= 0) {
+        bundle_close(&bundle);
+    } else {
+        close(docRootFd);
+    }
+    if (!draining) {
+        close(sockfd);
+    }
+    SSL_CTX_free(tlsContext);
     fprintf(stderr, "\nShutdown Server\n");
+    printPoolStats();
     exit(EXIT_SUCCESS);
-}
\ No newline at end of file
+}
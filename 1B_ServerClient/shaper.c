@@ -0,0 +1,107 @@
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+
+#include "shaper.h"
+
+/**
+ * file shaper.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Token buckets which limit the send rate of connections and of client addresses.
+ *
+ * @details Buckets are refilled lazily when they are asked for tokens, so an idle bucket costs nothing.
+ **/
+
+uint64_t shaper_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void token_bucket_init(struct token_bucket *bucket, long rate, uint64_t now) {
+    bucket->rate = rate;
+    bucket->burst = rate / 4 > SHAPER_MIN_BURST ? rate / 4 : SHAPER_MIN_BURST;
+    bucket->tokens = bucket->burst;
+    bucket->updated = now;
+}
+
+long token_bucket_available(struct token_bucket *bucket, uint64_t now) {
+    if (bucket->rate == 0) {
+        return LONG_MAX;
+    }
+    uint64_t elapsed = now - bucket->updated;
+    if (elapsed > 60000) { // the bucket is full long before, but the product must not overflow
+        elapsed = 60000;
+    }
+    long refill = (long) ((uint64_t) bucket->rate * elapsed / 1000);
+    if (refill > 0) { // below one byte the time keeps counting from the last refill
+        bucket->updated = now;
+        bucket->tokens = bucket->tokens + refill > bucket->burst ? bucket->burst : bucket->tokens + refill;
+    }
+    return bucket->tokens;
+}
+
+void token_bucket_take(struct token_bucket *bucket, long bytes) {
+    if (bucket->rate != 0) {
+        bucket->tokens -= bytes;
+    }
+}
+
+unsigned long token_bucket_delay(const struct token_bucket *bucket, long tokens) {
+    if (bucket->rate == 0 || bucket->tokens >= tokens) {
+        return 0;
+    }
+    return (unsigned long) ((uint64_t) (tokens - bucket->tokens) * 1000 / bucket->rate) + 1;
+}
+
+/**
+* @brief hash of a client address
+* @param address: the IPv6 address
+* @return the slot in the table
+**/
+static unsigned int addressSlot(const unsigned char address[16]) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 16; ++i) {
+        hash = (hash ^ address[i]) * 16777619u;
+    }
+    return hash % CLIENT_TABLE_SIZE;
+}
+
+void client_table_init(struct client_table *table, long rate) {
+    table->rate = rate;
+    pool_init(&table->pool, "client address", sizeof(struct client_limit));
+    memset(table->heads, 0, sizeof table->heads);
+}
+
+struct client_limit *client_table_get(struct client_table *table, const unsigned char address[16], uint64_t now) {
+    struct client_limit **head = &table->heads[addressSlot(address)];
+    for (struct client_limit *limit = *head; limit != NULL; limit = limit->next) {
+        if (memcmp(limit->address, address, 16) == 0) {
+            limit->refs++;
+            return limit;
+        }
+    }
+    struct client_limit *limit = pool_get(&table->pool);
+    if (limit == NULL) {
+        return NULL;
+    }
+    memcpy(limit->address, address, 16);
+    limit->refs = 1;
+    token_bucket_init(&limit->bucket, table->rate, now);
+    limit->next = *head;
+    *head = limit;
+    return limit;
+}
+
+void client_table_put(struct client_table *table, struct client_limit *limit) {
+    if (limit == NULL || --limit->refs > 0) {
+        return;
+    }
+    struct client_limit **link = &table->heads[addressSlot(limit->address)];
+    while (*link != limit) {
+        link = &(*link)->next;
+    }
+    *link = limit->next;
+    pool_put(&table->pool, limit);
+}
@@ -0,0 +1,106 @@
+/**
+ * file shaper.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Token buckets which limit the send rate of connections and of client addresses.
+ *
+ * @details A bucket holds up to burst bytes and is refilled with rate bytes per second. Sending is allowed
+ * while the bucket is not empty and may overdraw it, the debt is paid by the next refills. The buckets of
+ * client addresses are kept in a hash table and shared by all connections of the address.
+ **/
+
+#ifndef SHAPER_H
+#define SHAPER_H
+
+#include <stdint.h>
+
+#include "pool.h"
+
+#define SHAPER_MIN_BURST 16384
+#define CLIENT_TABLE_SIZE 1024
+
+struct token_bucket {
+    long rate; // bytes per second, 0 if the bucket does not limit
+    long burst;
+    long tokens; // negative after the bucket was overdrawn
+    uint64_t updated; // time of the last refill in milliseconds
+};
+
+/**
+ * bucket of one client address, counted references of its connections
+ **/
+struct client_limit {
+    struct client_limit *next;
+    unsigned char address[16]; // IPv6 address, IPv4 addresses are mapped
+    unsigned long refs;
+    struct token_bucket bucket;
+};
+
+struct client_table {
+    long rate; // bytes per second of every client address, 0 without limit
+    struct pool pool;
+    struct client_limit *heads[CLIENT_TABLE_SIZE];
+};
+
+/**
+* @brief returns the current monotonic time
+* @return the time in milliseconds
+**/
+uint64_t shaper_now(void);
+
+/**
+* @brief initialize a full bucket
+* @details the burst is a quarter of a second of the rate, at least SHAPER_MIN_BURST
+* @param bucket: the bucket
+* @param rate: bytes per second or 0 without limit
+* @param now: current time in milliseconds
+**/
+void token_bucket_init(struct token_bucket *bucket, long rate, uint64_t now);
+
+/**
+* @brief refill the bucket and return its tokens
+* @param bucket: the bucket
+* @param now: current time in milliseconds
+* @return the tokens, LONG_MAX if the bucket does not limit
+**/
+long token_bucket_available(struct token_bucket *bucket, uint64_t now);
+
+/**
+* @brief take sent bytes from the bucket
+* @param bucket: the bucket
+* @param bytes: number of sent bytes
+**/
+void token_bucket_take(struct token_bucket *bucket, long bytes);
+
+/**
+* @brief time until the bucket holds enough tokens
+* @param bucket: the bucket after token_bucket_available
+* @param tokens: wanted tokens, at most the burst
+* @return milliseconds until the tokens are available
+**/
+unsigned long token_bucket_delay(const struct token_bucket *bucket, long tokens);
+
+/**
+* @brief initialize an empty table of client addresses
+* @param table: the table
+* @param rate: bytes per second of every client address
+**/
+void client_table_init(struct client_table *table, long rate);
+
+/**
+* @brief get the bucket of a client address and take a reference
+* @param table: the table
+* @param address: the IPv6 address of the client
+* @param now: current time in milliseconds
+* @return the bucket or NULL if no memory is left
+**/
+struct client_limit *client_table_get(struct client_table *table, const unsigned char address[16], uint64_t now);
+
+/**
+* @brief drop a reference, the bucket is freed with the last connection of the address
+* @param table: the table
+* @param limit: the bucket or NULL
+**/
+void client_table_put(struct client_table *table, struct client_limit *limit);
+
+#endif
@@ -0,0 +1,174 @@
+#include <stddef.h>
+#include <time.h>
+
+#include "timer.h"
+
+/**
+ * file timer.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Hierarchical timer wheel for connection deadlines.
+ *
+ * @details Level 0 holds the timers of the next TIMER_SLOTS ticks, every upper level holds TIMER_SLOTS
+ * times the range of the level below. Whenever the index of a level wraps around, the next slot of the
+ * upper level is cascaded, i.e. its timers are inserted again and land in a lower level.
+ **/
+
+/**
+* @brief insert a timer into the list of a slot
+* @param head: head of the slot list
+* @param timer: the timer
+**/
+static void listAdd(struct timer *head, struct timer *timer) {
+    timer->next = head->next;
+    timer->prev = head;
+    head->next->prev = timer;
+    head->next = timer;
+}
+
+/**
+* @brief remove a timer from the list it is in
+* @param timer: the timer
+**/
+static void listDel(struct timer *timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/**
+* @brief insert a timer into the slot which matches its expiry
+* @param wheel: the wheel
+* @param timer: the timer
+**/
+static void insertTimer(struct timer_wheel *wheel, struct timer *timer) {
+    uint64_t expires = timer->expires;
+    uint64_t delta = expires - wheel->tick;
+    struct timer *head;
+
+    if (expires < wheel->tick) { // already expired, fire in the next processed tick
+        head = &wheel->slots[0][wheel->tick & TIMER_SLOT_MASK];
+    } else if (delta < (1ULL << TIMER_SLOT_BITS)) {
+        head = &wheel->slots[0][expires & TIMER_SLOT_MASK];
+    } else if (delta < (1ULL << (2 * TIMER_SLOT_BITS))) {
+        head = &wheel->slots[1][(expires >> TIMER_SLOT_BITS) & TIMER_SLOT_MASK];
+    } else if (delta < (1ULL << (3 * TIMER_SLOT_BITS))) {
+        head = &wheel->slots[2][(expires >> (2 * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK];
+    } else {
+        if (delta >= (1ULL << (4 * TIMER_SLOT_BITS))) { // clamp to the range of the wheel
+            expires = wheel->tick + (1ULL << (4 * TIMER_SLOT_BITS)) - 1;
+            timer->expires = expires;
+        }
+        head = &wheel->slots[3][(expires >> (3 * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK];
+    }
+    listAdd(head, timer);
+}
+
+/**
+* @brief move all timers of a slot in an upper level down
+* @param wheel: the wheel
+* @param level: level of the slot
+* @param index: index of the slot
+* @return the index of the slot
+**/
+static unsigned int cascade(struct timer_wheel *wheel, int level, unsigned int index) {
+    struct timer *head = &wheel->slots[level][index];
+    while (head->next != head) {
+        struct timer *timer = head->next;
+        listDel(timer);
+        insertTimer(wheel, timer);
+    }
+    return index;
+}
+
+uint64_t timer_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * (1000 / TIMER_TICK_MS) + (uint64_t) ts.tv_nsec / (TIMER_TICK_MS * 1000000ULL);
+}
+
+void timer_wheel_init(struct timer_wheel *wheel, uint64_t now) {
+    wheel->tick = now;
+    wheel->pending = 0;
+    for (int level = 0; level < TIMER_LEVELS; ++level) {
+        for (int slot = 0; slot < TIMER_SLOTS; ++slot) {
+            wheel->slots[level][slot].next = &wheel->slots[level][slot];
+            wheel->slots[level][slot].prev = &wheel->slots[level][slot];
+        }
+    }
+}
+
+void timer_init(struct timer *timer, timer_callback callback) {
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->callback = callback;
+}
+
+int timer_armed(const struct timer *timer) {
+    return timer->next != NULL;
+}
+
+void timer_arm(struct timer_wheel *wheel, struct timer *timer, unsigned long timeout_ms) {
+    if (timer_armed(timer)) {
+        listDel(timer);
+    } else {
+        if (wheel->pending == 0) { // an empty wheel is not advanced while the event loop sleeps, catch up
+            wheel->tick = timer_now() + 1;
+        }
+        wheel->pending++;
+    }
+    // the event loop advances the wheel after every wakeup, so wheel->tick is the tick after now
+    timer->expires = wheel->tick + (timeout_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    insertTimer(wheel, timer);
+}
+
+void timer_cancel(struct timer_wheel *wheel, struct timer *timer) {
+    if (timer_armed(timer)) {
+        listDel(timer);
+        wheel->pending--;
+    }
+}
+
+void timer_wheel_advance(struct timer_wheel *wheel, uint64_t now) {
+    while (wheel->tick <= now) {
+        if (wheel->pending == 0) { // nothing to cascade or expire, skip the idle ticks
+            wheel->tick = now + 1;
+            break;
+        }
+        unsigned int index = wheel->tick & TIMER_SLOT_MASK;
+
+        if (index == 0 &&
+            cascade(wheel, 1, (wheel->tick >> TIMER_SLOT_BITS) & TIMER_SLOT_MASK) == 0 &&
+            cascade(wheel, 2, (wheel->tick >> (2 * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK) == 0) {
+            cascade(wheel, 3, (wheel->tick >> (3 * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK);
+        }
+
+        // detach the expired list first, callbacks may arm timers for the current tick again
+        struct timer expired;
+        struct timer *head = &wheel->slots[0][index];
+        if (head->next == head) {
+            wheel->tick++;
+            continue;
+        }
+        expired.next = head->next;
+        expired.prev = head->prev;
+        expired.next->prev = &expired;
+        expired.prev->next = &expired;
+        head->next = head;
+        head->prev = head;
+        wheel->tick++;
+
+        while (expired.next != &expired) {
+            struct timer *timer = expired.next;
+            listDel(timer);
+            wheel->pending--;
+            timer->callback(timer);
+        }
+    }
+}
+
+int timer_wheel_timeout(const struct timer_wheel *wheel) {
+    return wheel->pending > 0 ? TIMER_TICK_MS : -1;
+}
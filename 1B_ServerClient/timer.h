@@ -0,0 +1,98 @@
+/**
+ * file timer.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief Hierarchical timer wheel for connection deadlines.
+ *
+ * @details Timers are intrusive list nodes which are embedded in the object they belong to, so adding,
+ * re-arming and cancelling a timer never allocates and is O(1). The wheel has TIMER_LEVELS levels with
+ * TIMER_SLOTS slots each; timers far in the future are kept in the upper levels and cascaded down when
+ * the lower level wraps around. One tick only touches the slot which expires in that tick.
+ **/
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+#define TIMER_TICK_MS 100
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+#define TIMER_LEVELS 4
+
+struct timer;
+
+typedef void (*timer_callback)(struct timer *timer);
+
+struct timer {
+    struct timer *next;
+    struct timer *prev;
+    uint64_t expires; // tick in which the timer fires
+    timer_callback callback;
+};
+
+struct timer_wheel {
+    uint64_t tick; // next tick which will be processed
+    unsigned long pending; // number of armed timers
+    struct timer slots[TIMER_LEVELS][TIMER_SLOTS]; // list heads
+};
+
+/**
+* @brief returns the current monotonic time in ticks
+* @return the current time in ticks of TIMER_TICK_MS
+**/
+uint64_t timer_now(void);
+
+/**
+* @brief initialize the timer wheel
+* @param wheel: the wheel
+* @param now: current time in ticks
+**/
+void timer_wheel_init(struct timer_wheel *wheel, uint64_t now);
+
+/**
+* @brief initialize a timer which is not armed
+* @param timer: the timer
+* @param callback: function which is called when the timer expires
+**/
+void timer_init(struct timer *timer, timer_callback callback);
+
+/**
+* @brief arm (or re-arm) a timer
+* @param wheel: the wheel
+* @param timer: the timer
+* @param timeout_ms: milliseconds from now until the timer fires
+**/
+void timer_arm(struct timer_wheel *wheel, struct timer *timer, unsigned long timeout_ms);
+
+/**
+* @brief cancel a timer, it is safe to cancel a timer which is not armed
+* @param wheel: the wheel
+* @param timer: the timer
+**/
+void timer_cancel(struct timer_wheel *wheel, struct timer *timer);
+
+/**
+* @brief checks if a timer is armed
+* @param timer: the timer
+* @return 1 if the timer is armed and else returns 0
+**/
+int timer_armed(const struct timer *timer);
+
+/**
+* @brief run all timers which expired until now
+* @details the timer is disarmed before its callback is called, so the callback may re-arm it or free
+* the object it is embedded in
+* @param wheel: the wheel
+* @param now: current time in ticks
+**/
+void timer_wheel_advance(struct timer_wheel *wheel, uint64_t now);
+
+/**
+* @brief timeout for the event loop
+* @return milliseconds until the next tick if timers are pending and else -1
+**/
+int timer_wheel_timeout(const struct timer_wheel *wheel);
+
+#endif
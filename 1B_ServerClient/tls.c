@@ -0,0 +1,82 @@
+#include <stdio.h>
+
+#include <openssl/err.h>
+
+#include "tls.h"
+
+/**
+ * file tls.c
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief TLS contexts for the server and the client (OpenSSL).
+ *
+ * @details Only TLS 1.2 and 1.3 are enabled, both have AEAD ciphers which the kernel can take over.
+ **/
+
+// ALPN protocols of the server in wire format, in the order of preference
+static const unsigned char alpnProtocols[] = "\x02h2\x08http/1.1";
+
+/**
+* @brief selects the ALPN protocol of a connection, called by OpenSSL during the handshake
+* @return SSL_TLSEXT_ERR_OK if a protocol was selected and else SSL_TLSEXT_ERR_NOACK
+**/
+static int selectAlpn(SSL *ssl, const unsigned char **out, unsigned char *outLen, const unsigned char *in,
+                      unsigned int inLen, void *arg) {
+    unsigned char *selected;
+    if (SSL_select_next_proto(&selected, outLen, alpnProtocols, sizeof alpnProtocols - 1, in, inLen) !=
+        OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK; // continue without ALPN, the client gets HTTP/1.1
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+void tls_print_errors(const char *programName) {
+    unsigned long error;
+    while ((error = ERR_get_error()) != 0) {
+        char message[256];
+        ERR_error_string_n(error, message, sizeof message);
+        fprintf(stderr, "Error in %s: %s\n", programName, message);
+    }
+}
+
+SSL_CTX *tls_server_context(const char *certFile, const char *keyFile, int kernelTls) {
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    if (ctx == NULL) {
+        return NULL;
+    }
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    // the send loops retry with the remaining bytes, which may not be the buffer of the first attempt
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (kernelTls) {
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+    if (SSL_CTX_use_certificate_chain_file(ctx, certFile) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx, keyFile, SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    SSL_CTX_set_alpn_select_cb(ctx, selectAlpn, NULL);
+    return ctx;
+}
+
+SSL_CTX *tls_client_context(const char *caFile) {
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    if (ctx == NULL) {
+        return NULL;
+    }
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+    int loaded = caFile != NULL ? SSL_CTX_load_verify_locations(ctx, caFile, NULL)
+                                : SSL_CTX_set_default_verify_paths(ctx);
+    if (loaded != 1) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+int tls_kernel_send(SSL *ssl) {
+    return BIO_get_ktls_send(SSL_get_wbio(ssl)) ? 1 : 0;
+}
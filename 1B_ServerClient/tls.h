@@ -0,0 +1,49 @@
+/**
+ * file tls.h
+ * @author Miriam Gehbauer <e11708473@student.tuwien.ac.at>
+ * @date 18.10.2026
+ * @brief TLS contexts for the server and the client (OpenSSL).
+ *
+ * @details The handshake is always done by OpenSSL in user space. If kernel TLS is requested and the kernel
+ * supports it (tls module loaded, AES-GCM or ChaCha20-Poly1305 cipher), OpenSSL installs the session keys
+ * on the socket afterwards (TLS_TX and, if possible, TLS_RX). From then on the kernel encrypts everything
+ * which is written to the socket, so plain send, sendmsg and sendfile keep working and file bodies never
+ * leave the kernel.
+ **/
+
+#ifndef TLS_H
+#define TLS_H
+
+#include <openssl/ssl.h>
+
+/**
+* @brief create the context of a TLS server
+* @details the server offers the ALPN protocols "h2" and "http/1.1"
+* @param certFile: PEM file with the certificate chain
+* @param keyFile: PEM file with the private key
+* @param kernelTls: 1 to hand the encryption to the kernel after the handshake
+* @return the context or NULL if the certificate or the key cannot be loaded
+**/
+SSL_CTX *tls_server_context(const char *certFile, const char *keyFile, int kernelTls);
+
+/**
+* @brief create the context of a TLS client which verifies the server
+* @param caFile: PEM file with trusted certificates or NULL for the default trust store
+* @return the context or NULL on error
+**/
+SSL_CTX *tls_client_context(const char *caFile);
+
+/**
+* @brief checks if the kernel encrypts the records which are sent on the connection
+* @param ssl: connection after the handshake
+* @return 1 if kernel TLS is used for sending and else returns 0
+**/
+int tls_kernel_send(SSL *ssl);
+
+/**
+* @brief print the OpenSSL error queue
+* @param programName: name of the program which is printed before every error
+**/
+void tls_print_errors(const char *programName);
+
+#endif